@@ -0,0 +1,116 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "meta/function.hpp"
+#include "meta/runtime/batch.hpp"
+#include "meta/runtime/compiler.hpp"
+
+#define STRINGIFY_(...) #__VA_ARGS__
+#define STRINGIFY(...) STRINGIFY_(__VA_ARGS__)
+
+#define FORMULA0 (a b c) -> ((a + b) * (c - a)) * 10
+#define FORMULA1 (a b c) -> ((a * 3 - b * 5 + c <= -a + 17)) + ~b - !c
+#define FORMULA2 (a b c) -> a / (b - c) + ((a > b)) - a - b - c
+
+using meta::runtime::Value;
+
+static auto now() {
+    return std::chrono::steady_clock::now();
+}
+
+static auto seconds(auto from, auto to) -> double {
+    return std::chrono::duration<double>(to - from).count();
+}
+
+/** checks the runtime program against the $fn closure on a sample of rows, `skip` filters rows undefined for $fn **/
+static auto verify(const meta::runtime::Program& program, auto fn, auto skip, const std::vector<Value> (&columns)[3]) -> bool {
+    for (size_t i = 0; i < std::min<size_t>(columns[0].size(), 4096); ++i) {
+        Value args[] = {columns[0][i], columns[1][i], columns[2][i]};
+        if (skip(args[0], args[1], args[2])) {
+            continue;
+        }
+        auto expected = static_cast<Value>(fn(args[0], args[1], args[2]));
+        if (program(args) != expected) {
+            std::fprintf(stderr, "mismatch at row %zu: %d != %d\n", i, program(args), expected);
+            return false;
+        }
+    }
+    return true;
+}
+
+static auto bench(const char* source, auto fn, size_t rows, auto skip) -> bool {
+    auto program = meta::runtime::compile(source);
+    if (!program) {
+        std::fprintf(stderr, "%s: %.*s at %zu\n", source, int(program.error().message.size()), program.error().message.data(), program.error().offset);
+        return false;
+    }
+
+    std::vector<Value> columns[3];
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<Value> dist(-1000, 1000);
+    for (auto& column : columns) {
+        column.resize(rows);
+        for (auto& v : column) {
+            v = dist(rng);
+        }
+    }
+    if (!verify(*program, fn, skip, columns)) {
+        return false;
+    }
+
+    std::span<const Value> spans[] = {columns[0], columns[1], columns[2]};
+    std::vector<Value> reference(rows);
+    std::vector<Value> out(rows);
+
+    auto start = now();
+    for (size_t i = 0; i < rows; ++i) {
+        Value args[] = {columns[0][i], columns[1][i], columns[2][i]};
+        reference[i] = (*program)(args);
+    }
+    auto row_time = seconds(start, now());
+    std::printf("%-56s %10zu rows  %-8s %8.2f Mrows/s\n", source, rows, "row", double(rows) / row_time / 1e6);
+
+    for (auto isa : {meta::runtime::Isa::Scalar, meta::runtime::Isa::Sse2, meta::runtime::Isa::Avx2}) {
+        if (isa > meta::runtime::best_isa()) {
+            continue;
+        }
+        std::fill(out.begin(), out.end(), 0);
+        start = now();
+        meta::runtime::evaluate_batch(program->view(), spans, out, isa);
+        auto time = seconds(start, now());
+        if (out != reference) {
+            std::fprintf(stderr, "%s: %s batch differs from the scalar interpreter\n", source, meta::runtime::isa_name(isa));
+            return false;
+        }
+        std::printf("%-56s %10zu rows  %-8s %8.2f Mrows/s\n", source, rows, meta::runtime::isa_name(isa), double(rows) / time / 1e6);
+    }
+    return true;
+}
+
+auto main(int argc, char** argv) -> int {
+    std::vector<size_t> sizes = {1'000'000, 10'000'000, 100'000'000};
+    if (argc > 1) {
+        sizes.clear();
+        for (int i = 1; i < argc; ++i) {
+            sizes.emplace_back(std::strtoull(argv[i], nullptr, 10));
+        }
+    }
+
+    constexpr auto fn0 = $fn(FORMULA0);
+    constexpr auto fn1 = $fn(FORMULA1);
+    constexpr auto fn2 = $fn(FORMULA2);
+
+    for (auto rows : sizes) {
+        auto never = [](Value, Value, Value) { return false; };
+        auto ok = bench(STRINGIFY(FORMULA0), fn0, rows, never)
+               && bench(STRINGIFY(FORMULA1), fn1, rows, never)
+               // division by zero is undefined for $fn
+               && bench(STRINGIFY(FORMULA2), fn2, rows, [](Value, Value b, Value c) { return b == c; });
+        if (!ok) {
+            return 1;
+        }
+    }
+    return 0;
+}
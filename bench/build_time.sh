@@ -0,0 +1,96 @@
+#!/usr/bin/env bash
+#
+# Total compiler CPU time (user + sys of the whole build) of a formula library used from several translation units.
+#   inline - every consumer includes the formulas as `inline constexpr auto f = $fn(...)` and evaluates all of them
+#   units  - consumers include META_DECLARE_FN declarations, the formulas are defined by meta_grammar_units()
+#
+# usage: bench/build_time.sh [formulas] [consumers] [units] [jobs]
+#
+set -euo pipefail
+
+formulas=${1:-8}
+consumers=${2:-4}
+units=${3:-2}
+jobs=${4:-$(nproc)}
+
+root=$(cd "$(dirname "$0")/.." && pwd)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+RANDOM=7
+terms=(a b c d)
+ops=(+ - '*')
+{
+    echo '#pragma once'
+    echo '#include "meta/unit.hpp"'
+} > "$work/formulas.hpp"
+{
+    echo '#pragma once'
+    echo '#include "meta/function.hpp"'
+} > "$work/formulas_inline.hpp"
+: > "$work/formulas.meta"
+for ((i = 0; i < formulas; ++i)); do
+    body="($i"
+    for ((t = 0; t < 8 + RANDOM % 8; ++t)); do
+        body+=" ${ops[RANDOM % 3]} ${terms[RANDOM % 4]}"
+    done
+    body+=") * (a - ${terms[RANDOM % 4]})"
+    echo "META_DECLARE_FN(formula_$i, int(int, int, int, int));" >> "$work/formulas.hpp"
+    echo "inline constexpr auto formula_$i = \$fn((a b c d) -> $body);" >> "$work/formulas_inline.hpp"
+    printf 'META_DEFINE(formula_%d, Function, (a b c d) -> %s);\n\n' "$i" "$body" >> "$work/formulas.meta"
+done
+
+mkdir -p "$work/inline" "$work/units"
+for variant in inline units; do
+    header=$([ "$variant" = inline ] && echo formulas_inline.hpp || echo formulas.hpp)
+    for ((j = 0; j < consumers; ++j)); do
+        {
+            echo "#include \"$header\""
+            echo "auto consumer_$j(int x) -> int {"
+            echo "    int sum = 0;"
+            for ((i = 0; i < formulas; ++i)); do
+                echo "    sum += formula_$i(x, $j, $i, 3);"
+            done
+            echo "    return sum;"
+            echo "}"
+        } > "$work/$variant/consumer_$j.cpp"
+    done
+    {
+        for ((j = 0; j < consumers; ++j)); do
+            echo "auto consumer_$j(int x) -> int;"
+        done
+        echo "auto main(int argc, char**) -> int {"
+        echo "    return 0$(for ((j = 0; j < consumers; ++j)); do printf ' + consumer_%d(argc)' "$j"; done) == 0;"
+        echo "}"
+    } > "$work/$variant/main.cpp"
+done
+
+cat > "$work/CMakeLists.txt" <<EOF
+cmake_minimum_required(VERSION 3.24)
+project(build_time CXX)
+set(CMAKE_CXX_STANDARD 23)
+add_subdirectory("$root" meta EXCLUDE_FROM_ALL)
+
+file(GLOB inline_sources inline/*.cpp)
+add_executable(inline \${inline_sources})
+target_include_directories(inline PRIVATE .)
+target_link_libraries(inline PRIVATE meta)
+
+file(GLOB units_sources units/*.cpp)
+add_executable(units \${units_sources})
+target_include_directories(units PRIVATE .)
+target_link_libraries(units PRIVATE meta)
+meta_grammar_units(units DEFINITIONS formulas.meta UNITS $units PREAMBLE "$root/src/meta/function.hpp" formulas.hpp)
+EOF
+
+cmake -S "$work" -B "$work/build" -DCMAKE_BUILD_TYPE=Release > /dev/null
+
+echo "$formulas formulas used from $consumers translation units, $units grammar units, -j$jobs"
+printf '%-8s %10s %10s\n' variant "wall s" "cpu s"
+TIMEFORMAT='%R %U %S'
+for variant in inline units; do
+    times=$( { time cmake --build "$work/build" --target "$variant" -j"$jobs" > /dev/null; } 2>&1 )
+    read -r wall user sys <<< "$times"
+    "$work/build/$variant"
+    awk -v variant="$variant" -v wall="$wall" -v user="$user" -v sys="$sys" 'BEGIN { printf "%-8s %10.2f %10.2f\n", variant, wall, user + sys }'
+done
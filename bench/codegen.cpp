@@ -0,0 +1,189 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "meta/function.hpp"
+
+#ifndef META_BENCH_OPT
+#define META_BENCH_OPT "?"
+#endif
+
+/**
+ * Every formula is compiled twice from the same text, once through `$fn` and once as a hand-written lambda.
+ * noipa keeps each body out of line and hides it from the caller, so the timing and the disassembly
+ * see exactly what the closure compiled to.
+ **/
+#define FORMULA(name, ...)                                                                   \
+    extern "C" [[gnu::noipa]] auto codegen_fn_##name(int a, int b, int c, int d) -> int {   \
+        constexpr auto fn = apply_rules(Function, (a b c d) -> __VA_ARGS__);                 \
+        return fn(a, b, c, d);                                                               \
+    }                                                                                        \
+    extern "C" [[gnu::noipa]] auto codegen_hand_##name(int a, int b, int c, int d) -> int { \
+        constexpr auto fn = []([[maybe_unused]] int a, [[maybe_unused]] int b,               \
+                               [[maybe_unused]] int c, [[maybe_unused]] int d) {             \
+            return __VA_ARGS__;                                                              \
+        };                                                                                   \
+        return fn(a, b, c, d);                                                               \
+    }
+
+FORMULA(example, ((a + b) * (c - d)) * 10)
+FORMULA(squares, a * a + b * b)
+FORMULA(unary, -a + ~b + !c)
+FORMULA(compare, (a * b <= c + d))
+FORMULA(divide, (a + b) / (c + 1))
+FORMULA(products, a * b + c * d + a * c + b * d + a * d + b * c)
+FORMULA(nested, ((a + 1) * (b + 2)) * ((c + 3) * (d + 4)))
+
+struct Formula {
+    const char* name;
+    int (*fn)(int, int, int, int);
+    int (*hand)(int, int, int, int);
+};
+
+#define ENTRY(name) Formula{#name, codegen_fn_##name, codegen_hand_##name}
+
+static constexpr Formula formulas[] = {
+    ENTRY(example), ENTRY(squares), ENTRY(unary), ENTRY(compare), ENTRY(divide), ENTRY(products), ENTRY(nested),
+};
+
+struct Input {
+    int a, b, c, d;
+};
+
+static auto ns_per_call(int (*fn)(int, int, int, int), const std::vector<Input>& inputs, int repeats, int64_t& sum) -> double {
+    auto start = std::chrono::steady_clock::now();
+    for (int repeat = 0; repeat < repeats; ++repeat) {
+        for (const auto& [a, b, c, d] : inputs) {
+            sum += fn(a, b, c, d);
+        }
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / double(repeats * inputs.size());
+}
+
+struct Disassembly {
+    struct Symbol {
+        size_t instructions = 0;
+        std::set<std::string> callees;
+    };
+    std::map<std::string, Symbol> symbols;
+
+    /** instructions of `name` and of every function it calls or tail-calls, once each **/
+    auto reachable(const std::string& name) const -> size_t {
+        std::set<std::string> seen;
+        std::vector<std::string> pending{name};
+        size_t total = 0;
+        while (!pending.empty()) {
+            auto current = std::move(pending.back());
+            pending.pop_back();
+            auto it = symbols.find(current);
+            if (it == symbols.end() || !seen.insert(current).second) {
+                continue;
+            }
+            total += it->second.instructions;
+            pending.insert(pending.end(), it->second.callees.begin(), it->second.callees.end());
+        }
+        return total;
+    }
+};
+
+/** disassembles this executable, empty when objdump is not available **/
+static auto disassemble() -> Disassembly {
+    Disassembly disassembly;
+    // resolved here, inside objdump /proc/self would be objdump
+    char path[4096];
+    auto length = ::readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (length <= 0) {
+        return disassembly;
+    }
+    path[length] = 0;
+    auto command = std::string("objdump -d --no-show-raw-insn '") + path + "' 2>/dev/null";
+    auto* pipe = ::popen(command.c_str(), "r");
+    if (pipe == nullptr) {
+        return disassembly;
+    }
+    char line[4096];
+    Disassembly::Symbol* current = nullptr;
+    std::string name;
+    while (std::fgets(line, sizeof(line), pipe) != nullptr) {
+        std::string_view text(line);
+        if (auto open = text.find(" <"); open != std::string_view::npos && text.ends_with(">:\n")) {
+            name = text.substr(open + 2, text.size() - open - 5);
+            current = &disassembly.symbols[name];
+            continue;
+        }
+        if (current == nullptr || text.size() < 2 || text[0] != ' ' || text.find(":\t") == std::string_view::npos) {
+            continue;
+        }
+        current->instructions += 1;
+        // `call 1130 <callee>` or `jmp 1130 <callee>`, jumps inside the function carry a `+offset`
+        auto open = text.find('<');
+        auto close = text.find('>', open);
+        if (open != std::string_view::npos && close != std::string_view::npos) {
+            auto target = text.substr(open + 1, close - open - 1);
+            if (target.find('+') == std::string_view::npos && !target.ends_with("@plt") && target != name) {
+                current->callees.emplace(target);
+            }
+        }
+    }
+    ::pclose(pipe);
+    return disassembly;
+}
+
+auto main(int argc, char** argv) -> int {
+    auto repeats = argc > 1 ? std::atoi(argv[1]) : 200;
+
+    std::mt19937 rng(3);
+    std::vector<Input> inputs(4096);
+    for (auto& [a, b, c, d] : inputs) {
+        a = int(rng() % 100) + 1;
+        b = int(rng() % 100) + 1;
+        c = int(rng() % 100) + 1;
+        d = int(rng() % 100) + 1;
+    }
+    for (const auto& formula : formulas) {
+        for (const auto& [a, b, c, d] : inputs) {
+            if (formula.fn(a, b, c, d) != formula.hand(a, b, c, d)) {
+                std::fprintf(stderr, "%s: $fn and the lambda disagree\n", formula.name);
+                return 1;
+            }
+        }
+    }
+
+    auto disassembly = disassemble();
+    if (disassembly.symbols.empty()) {
+        std::printf("objdump is not available, instruction counts are skipped\n");
+    }
+
+    std::printf("-%s, %zu calls per measurement\n", META_BENCH_OPT, size_t(repeats) * inputs.size());
+    std::printf("%-10s %10s %10s %8s %12s %12s\n", "formula", "$fn ns", "hand ns", "ratio", "$fn instrs", "hand instrs");
+    int64_t sum = 0;
+    size_t flagged = 0;
+    for (const auto& formula : formulas) {
+        // best of interleaved runs, so a preempted run does not count against either side
+        auto fn_ns = std::numeric_limits<double>::max();
+        auto hand_ns = std::numeric_limits<double>::max();
+        for (int run = 0; run < 5; ++run) {
+            fn_ns = std::min(fn_ns, ns_per_call(formula.fn, inputs, repeats, sum));
+            hand_ns = std::min(hand_ns, ns_per_call(formula.hand, inputs, repeats, sum));
+        }
+        auto fn_instructions = disassembly.reachable(std::string("codegen_fn_") + formula.name);
+        auto hand_instructions = disassembly.reachable(std::string("codegen_hand_") + formula.name);
+
+        // a longer instruction path is overhead, a few percent of timing noise is not
+        auto overhead = fn_instructions > hand_instructions || fn_ns > hand_ns * 1.25;
+        flagged += overhead;
+        std::printf("%-10s %10.2f %10.2f %8.2f %12zu %12zu%s\n", formula.name, fn_ns, hand_ns, fn_ns / hand_ns,
+                    fn_instructions, hand_instructions, overhead ? "  <- forwarded arguments add overhead" : "");
+    }
+    std::printf("%zu of %zu formulas compile to more work than the hand-written lambda\n", flagged, std::size(formulas));
+    return sum != 0 ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <random>
+#include <string>
+
+#include <sys/resource.h>
+
+#include "meta/runtime/token_reader.hpp"
+
+/**
+ * writes `bytes` worth of generated rules, one formula per line separated by `;`, a malformed file starts
+ * with a stray `)` and has a rule with an unclosed `(` in every MiB, each of which must cost one error and nothing more
+ **/
+static auto generate(const char* path, size_t bytes, bool malformed) -> bool {
+    static constexpr const char* ops[] = {" + ", " - ", " * "};
+
+    auto* file = std::fopen(path, "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    std::mt19937 rng(3);
+    if (malformed) {
+        std::fputs(") ;\n", file);
+    }
+    // the valid rules are the same either way, the typos come on top of them
+    std::string chunk;
+    for (size_t written = 0; written < bytes; written += chunk.size()) {
+        if (malformed) {
+            std::fputs("(alpha beta gamma) -> (alpha + 1;\n", file);
+        }
+        chunk.clear();
+        while (chunk.size() < (1 << 20)) {
+            chunk += "(alpha beta gamma) -> ((alpha";
+            for (int term = 0; term < 6; ++term) {
+                chunk += ops[rng() % 3];
+                chunk += rng() % 2 ? "beta" : std::to_string(rng() % 1000);
+            }
+            chunk += " < gamma));\n";
+        }
+        std::fwrite(chunk.data(), 1, chunk.size(), file);
+    }
+    return std::fclose(file) == 0;
+}
+
+static auto max_rss_mb() -> double {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return double(usage.ru_maxrss) / 1024.0;
+}
+
+struct Run {
+    size_t snippets = 0;
+    size_t failures = 0;
+    size_t longest = 0;
+    int64_t checksum = 0;
+};
+
+static auto run(const char* path, size_t megabytes, bool malformed) -> std::optional<Run> {
+    if (!generate(path, megabytes << 20, malformed)) {
+        std::fprintf(stderr, "cannot write %s\n", path);
+        return std::nullopt;
+    }
+    std::printf("%s: generated %llu MiB into %s, max rss before parsing %.1f MiB\n", malformed ? "malformed" : "valid",
+                (unsigned long long) megabytes, path, max_rss_mb());
+
+    Run run;
+    auto start = std::chrono::steady_clock::now();
+    auto snippets = meta::runtime::compile_file(path, [&](const meta::runtime::Snippet& snippet, const meta::runtime::CompileResult& result) {
+        run.longest = std::max(run.longest, snippet.source.size());
+        if (!result) {
+            run.failures += 1;
+            return;
+        }
+        meta::runtime::Value args[] = {1, 2, 3};
+        run.checksum += (*result)(args);
+    });
+    auto time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::remove(path);
+
+    if (!snippets) {
+        std::fprintf(stderr, "%s: %s\n", path, snippets.error().message().c_str());
+        return std::nullopt;
+    }
+    run.snippets = *snippets;
+    std::printf("%zu snippets, %zu errors, longest %zu bytes, checksum %lld\n", run.snippets, run.failures, run.longest, (long long) run.checksum);
+    std::printf("%.2f s, %.1f MiB/s, max rss %.1f MiB\n", time, double(megabytes) / time, max_rss_mb());
+    return run;
+}
+
+auto main(int argc, char** argv) -> int {
+    auto megabytes = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1024;
+    auto path = argc > 2 ? argv[2] : "meta_rules.txt";
+
+    auto valid = run(path, megabytes, false);
+    if (!valid || valid->failures != 0) {
+        return 1;
+    }
+
+    // a typo costs exactly the snippet it is in, every valid rule of the same size file still compiles
+    auto malformed_megabytes = std::min<unsigned long long>(megabytes, 64);
+    auto reference = malformed_megabytes == megabytes ? valid : run(path, malformed_megabytes, false);
+    auto malformed = run(path, malformed_megabytes, true);
+    auto typos = 1 + malformed_megabytes;
+    if (!reference || !malformed || malformed->failures != typos || malformed->snippets - malformed->failures != reference->snippets) {
+        std::fprintf(stderr, "malformed rules were not contained\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,150 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+#include "meta/runtime/incremental.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+/** a balanced expression `depth` levels deep, so the parse stays within max_nesting whatever the size **/
+static void generate(std::string& out, std::mt19937& rng, int depth) {
+    static constexpr const char* names[] = {"alpha", "beta", "gamma"};
+    static constexpr const char* ops[] = {" + ", " - ", " * "};
+
+    if (depth == 0) {
+        out += rng() % 2 ? names[rng() % 3] : std::to_string(rng() % 1000);
+        return;
+    }
+    out += '(';
+    generate(out, rng, depth - 1);
+    out += ops[rng() % 3];
+    generate(out, rng, depth - 1);
+    out += ')';
+}
+
+static auto same(const meta::runtime::CompileResult& lhs, const meta::runtime::CompileResult& rhs) -> bool {
+    if (!lhs || !rhs) {
+        return !lhs && !rhs && lhs.error().offset == rhs.error().offset && lhs.error().message == rhs.error().message;
+    }
+    return lhs->params == rhs->params && lhs->constants == rhs->constants && lhs->stack_size == rhs->stack_size
+        && std::equal(lhs->code.begin(), lhs->code.end(), rhs->code.begin(), rhs->code.end(), [](auto a, auto b) {
+            return a.op == b.op && a.arg == b.arg;
+        });
+}
+
+/**
+ * Writes `message` into a pipe in `chunk` sized pieces, `interval` apart, like a slow peer would,
+ * and records when the last byte was handed to the kernel.
+ **/
+struct Writer {
+    std::string_view message;
+    size_t chunk;
+    std::chrono::microseconds interval;
+    std::atomic<Clock::time_point> last_byte{};
+    std::thread thread{};
+
+    void start(int fd) {
+        thread = std::thread([this, fd] {
+            for (size_t offset = 0; offset < message.size(); offset += chunk) {
+                std::this_thread::sleep_for(interval);
+                auto piece = message.substr(offset, chunk);
+                for (size_t written = 0; written < piece.size();) {
+                    auto n = ::write(fd, piece.data() + written, piece.size() - written);
+                    if (n <= 0) {
+                        std::abort();
+                    }
+                    written += static_cast<size_t>(n);
+                }
+            }
+            last_byte.store(Clock::now());
+            ::close(fd);
+        });
+    }
+};
+
+struct Run {
+    meta::runtime::CompileResult result;
+    double latency;
+};
+
+/** reads the pipe until EOF, feeding the incremental compiler or buffering for a single compile() at the end **/
+template<bool Incremental>
+static auto receive(std::string_view message, size_t chunk, std::chrono::microseconds interval) -> Run {
+    int fds[2];
+    if (::pipe(fds) != 0) {
+        std::abort();
+    }
+    Writer writer{message, chunk, interval};
+    writer.start(fds[1]);
+
+    meta::runtime::IncrementalCompiler compiler;
+    std::string buffered;
+    char buffer[64 * 1024];
+    while (true) {
+        auto n = ::read(fds[0], buffer, sizeof(buffer));
+        if (n <= 0) {
+            break;
+        }
+        if constexpr (Incremental) {
+            compiler.feed(std::string_view(buffer, static_cast<size_t>(n)));
+        } else {
+            buffered.append(buffer, static_cast<size_t>(n));
+        }
+    }
+    auto result = Incremental ? compiler.finish() : meta::runtime::compile(buffered);
+    auto done = Clock::now();
+
+    writer.thread.join();
+    ::close(fds[0]);
+    return Run{std::move(result), std::chrono::duration<double, std::micro>(done - writer.last_byte.load()).count()};
+}
+
+auto main(int argc, char** argv) -> int {
+    auto depth = argc > 1 ? std::atoi(argv[1]) : 16;
+    size_t chunk = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4096;
+    auto interval = std::chrono::microseconds(argc > 3 ? std::atoi(argv[3]) : 200);
+
+    std::mt19937 rng(7);
+    std::string message = "(alpha beta gamma) -> ";
+    generate(message, rng, depth);
+    auto expected = meta::runtime::compile(message);
+    if (!expected) {
+        std::fprintf(stderr, "reference compile failed: %.*s\n", int(expected.error().message.size()), expected.error().message.data());
+        return 1;
+    }
+
+    // every split point, including ones inside identifiers, numbers and `->`
+    std::string_view small = "(alpha beta) -> ((alpha * 12) <= -beta) + 345";
+    for (size_t split = 0; split <= small.size(); ++split) {
+        meta::runtime::IncrementalCompiler compiler;
+        compiler.feed(small.substr(0, split));
+        compiler.feed(small.substr(split));
+        if (!same(compiler.finish(), meta::runtime::compile(small))) {
+            std::fprintf(stderr, "split at %zu differs from compile()\n", split);
+            return 1;
+        }
+    }
+    // errors are found before the input ends
+    meta::runtime::IncrementalCompiler early;
+    if (!early.feed("(a) -> b + a") || early.finish().error().offset != 7) {
+        std::fprintf(stderr, "unknown parameter was not reported early\n");
+        return 1;
+    }
+
+    std::printf("%zu bytes in %zu byte chunks every %lld us\n", message.size(), chunk, (long long) interval.count());
+    auto buffered = receive<false>(message, chunk, interval);
+    auto incremental = receive<true>(message, chunk, interval);
+    if (!same(buffered.result, expected) || !same(incremental.result, expected)) {
+        std::fprintf(stderr, "results differ from compile()\n");
+        return 1;
+    }
+    std::printf("%-12s %10.1f us after the last byte\n", "buffered", buffered.latency);
+    std::printf("%-12s %10.1f us after the last byte\n", "incremental", incremental.latency);
+    return 0;
+}
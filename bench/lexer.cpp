@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "meta/runtime/lexer.hpp"
+
+/** formulas with long identifiers, wide numbers and indentation, plus some noise bytes **/
+static auto generate(size_t bytes) -> std::string {
+    static constexpr const char* names[] = {"price", "quantity_total", "discount_rate_2026", "x", "TaxRateForRegion", "_tmp"};
+    static constexpr const char* ops[] = {" + ", " - ", " * ", " / ", " <= ", " -> ", ", ", "; ", " => ", " ~", " !"};
+
+    std::mt19937 rng(5);
+    std::string text;
+    text.reserve(bytes + 256);
+    while (text.size() < bytes) {
+        text += "\n        (";
+        for (int term = 0; term < 12; ++term) {
+            if (rng() % 3 == 0) {
+                text += std::to_string(rng());
+            } else {
+                text += names[rng() % 6];
+            }
+            text += ops[rng() % 11];
+            if (rng() % 16 == 0) {
+                text += "\t\t    \r\n                                        ";
+            }
+        }
+        text += rng() % 64 == 0 ? "@#\x01)" : "1)";
+    }
+    return text;
+}
+
+struct Collected {
+    std::vector<Token> tokens;
+    std::vector<size_t> offsets;
+};
+
+static auto reference(std::string_view s) -> Collected {
+    Collected out;
+    SourceStream source_stream{s, 0};
+    while (true) {
+        while (source_stream.i < s.size() && SourceStream::is_space_char(s[source_stream.i])) {
+            source_stream.i++;
+        }
+        auto from = source_stream.i;
+        auto tk = source_stream.token();
+        if (tk.is_end()) {
+            return out;
+        }
+        out.tokens.emplace_back(tk);
+        out.offsets.emplace_back(from);
+    }
+}
+
+static auto same(const Collected& lhs, const Collected& rhs) -> bool {
+    return lhs.offsets == rhs.offsets && std::equal(lhs.tokens.begin(), lhs.tokens.end(), rhs.tokens.begin(), rhs.tokens.end(), [](auto a, auto b) {
+        return a.type == b.type && a.id == b.id;
+    });
+}
+
+auto main(int argc, char** argv) -> int {
+    auto megabytes = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 256;
+    auto text = generate(megabytes << 20);
+    auto gigabytes = double(text.size()) / 1e9;
+
+    auto start = std::chrono::steady_clock::now();
+    auto expected = reference(text);
+    auto time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%zu bytes, %zu tokens\n", text.size(), expected.tokens.size());
+    std::printf("%-16s %8.3f GB/s\n", "SourceStream", gigabytes / time);
+
+    for (auto isa : {meta::runtime::Isa::Scalar, meta::runtime::Isa::Sse42, meta::runtime::Isa::Avx2}) {
+        if (isa > meta::runtime::best_isa()) {
+            continue;
+        }
+        Collected actual;
+        actual.tokens.reserve(expected.tokens.size());
+        actual.offsets.reserve(expected.offsets.size());
+
+        start = std::chrono::steady_clock::now();
+        meta::runtime::scan_tokens(text, [&](Token tk, size_t offset) {
+            actual.tokens.emplace_back(tk);
+            actual.offsets.emplace_back(offset);
+        }, isa);
+        time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (!same(actual, expected)) {
+            std::fprintf(stderr, "%s: tokens differ from SourceStream\n", meta::runtime::isa_name(isa));
+            return 1;
+        }
+        std::printf("%-16s %8.3f GB/s\n", meta::runtime::isa_name(isa), gigabytes / time);
+    }
+
+    // only the fnv1a hashes of the identifiers, the serial part no scanner can avoid
+    start = std::chrono::steady_clock::now();
+    uint32_t hashes = 0;
+    for (size_t i = 0; i < text.size();) {
+        auto end = i;
+        while (end < text.size() && SourceStream::is_identifier_char(text[end])) {
+            end++;
+        }
+        hashes += end > i ? fnv1a(std::string_view(text).substr(i, end - i)) : 0;
+        i = std::max(end, i + 1);
+    }
+    time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%-16s %8.3f GB/s (%u)\n", "fnv1a only", gigabytes / time, hashes & 1);
+
+    // token-at-a-time interface, as used by TokenReader
+    meta::runtime::FastSourceStream stream{text};
+    size_t count = 0;
+    start = std::chrono::steady_clock::now();
+    for (auto tk = stream.token(); !tk.is_end(); tk = stream.token()) {
+        if (tk.type != expected.tokens[count].type || tk.id != expected.tokens[count].id || stream.from != expected.offsets[count]) {
+            std::fprintf(stderr, "FastSourceStream: token %zu differs from SourceStream\n", count);
+            return 1;
+        }
+        count += 1;
+    }
+    time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%-16s %8.3f GB/s\n", "FastSourceStream", gigabytes / time);
+    return count == expected.tokens.size() ? 0 : 1;
+}
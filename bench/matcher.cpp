@@ -0,0 +1,184 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "meta/meta_rules.hpp"
+#include "meta/runtime/compiler.hpp"
+#include "meta/runtime/matcher.hpp"
+
+using FunctionPattern = macro_rules(($($param:ident)*) -> $body:expr);
+using MessagePattern = macro_rules({ $($key:ident => $value:number ;)* });
+
+static void generate_expression(std::string& out, std::mt19937& rng, int depth) {
+    static constexpr const char* names[] = {"alpha", "beta", "gamma"};
+    static constexpr const char* ops[] = {" + ", " - ", " * ", " / "};
+    static constexpr const char* cmps[] = {" < ", " <= ", " > ", " >= "};
+
+    switch (depth == 0 ? 0 : rng() % 5) {
+        case 0:
+            out += rng() % 2 ? names[rng() % 3] : std::to_string(rng() % 1000);
+            break;
+        case 1:
+            out += rng() % 2 ? "-" : "~";
+            generate_expression(out, rng, depth - 1);
+            break;
+        case 2:
+            out += '(';
+            generate_expression(out, rng, depth - 1);
+            out += cmps[rng() % 4];
+            generate_expression(out, rng, depth - 1);
+            out += ')';
+            break;
+        case 3:
+            out += '(';
+            generate_expression(out, rng, depth - 1);
+            out += ')';
+            break;
+        default:
+            generate_expression(out, rng, depth - 1);
+            out += ops[rng() % 4];
+            generate_expression(out, rng, depth - 1);
+            break;
+    }
+}
+
+static auto tokens_of(std::string_view source) -> std::vector<Token> {
+    std::vector<Token> tokens;
+    meta::runtime::scan_tokens(source, [&](Token tk, size_t) {
+        tokens.emplace_back(tk);
+    });
+    return tokens;
+}
+
+/** deletes, duplicates or replaces one token, which makes most inputs invalid **/
+static auto mutate(std::vector<Token> tokens, std::mt19937& rng) -> std::vector<Token> {
+    static constexpr TokenType types[] = {TokenType::LeftParen, TokenType::RightParen, TokenType::Plus, TokenType::LessThan, TokenType::Arrow, TokenType::Number};
+
+    auto at = rng() % tokens.size();
+    switch (rng() % 3) {
+        case 0:
+            tokens.erase(tokens.begin() + at);
+            break;
+        case 1:
+            tokens.insert(tokens.begin() + at, tokens[at]);
+            break;
+        default:
+            tokens[at] = Token{types[rng() % 6], tokens[at].id};
+            break;
+    }
+    return tokens;
+}
+
+/** hand-written check of `{ (ident => number ;)* }` **/
+static auto is_message(const std::vector<Token>& tokens) -> bool {
+    if (tokens.size() < 2 || !tokens.front().is(TokenType::LeftCurly) || !tokens.back().is(TokenType::RightCurly) || (tokens.size() - 2) % 4 != 0) {
+        return false;
+    }
+    for (size_t i = 1; i + 1 < tokens.size(); i += 4) {
+        if (!tokens[i].is(TokenType::Identifier) || !tokens[i + 1].is(TokenType::FatArrow) || !tokens[i + 2].is(TokenType::Number) || !tokens[i + 3].is(TokenType::Semicolon)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename Fn>
+static auto ns_per_token(const std::vector<std::vector<Token>>& inputs, size_t total, Fn&& fn) -> double {
+    auto start = std::chrono::steady_clock::now();
+    for (int repeat = 0; repeat < 10; ++repeat) {
+        for (const auto& tokens : inputs) {
+            fn(tokens);
+        }
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / double(10 * total);
+}
+
+auto main() -> int {
+    constexpr auto& function_table = meta::runtime::match_table<FunctionPattern>;
+    constexpr auto& message_table = meta::runtime::match_table<MessagePattern>;
+    std::printf("function pattern: %zu states, message pattern: %zu states\n", function_table.states.size(), message_table.states.size());
+
+    meta::runtime::Matcher function_matcher(function_table);
+    meta::runtime::Matcher message_matcher(message_table);
+
+    // captures
+    std::vector<meta::runtime::Capture> captures;
+    auto sample = tokens_of("(alpha beta gamma) -> alpha * (beta + 1)");
+    if (!function_matcher.match(sample, captures) || captures.size() != 4 || captures[3].name != fnv1a("body") || captures[3].begin != 6 || captures[3].end != sample.size()) {
+        std::fprintf(stderr, "function captures are wrong\n");
+        return 1;
+    }
+    auto message = tokens_of("{ price => 10; quantity => 3; }");
+    if (!message_matcher.match(message, captures) || captures.size() != 4 || captures[1].name != fnv1a("value") || captures[1].begin != 3) {
+        std::fprintf(stderr, "message captures are wrong\n");
+        return 1;
+    }
+
+    // verdicts agree with the runtime compiler on valid and broken formulas
+    std::mt19937 rng(11);
+    std::vector<std::vector<Token>> inputs;
+    size_t total = 0;
+    size_t valid = 0;
+    size_t compared = 0;
+    for (int i = 0; i < 20000; ++i) {
+        std::string source = "(alpha beta gamma) -> ";
+        generate_expression(source, rng, 6);
+        auto tokens = tokens_of(source);
+        if (i % 2 == 1) {
+            tokens = mutate(std::move(tokens), rng);
+        }
+
+        std::pmr::vector<size_t> offsets(tokens.size(), 0);
+        auto compiled = meta::runtime::compile_tokens(source, tokens, offsets);
+        // the matcher validates syntax only, undeclared names are the compiler's business
+        if (compiled || compiled.error().message != std::string_view("unknown parameter")) {
+            if (function_matcher.match(tokens) != compiled.has_value()) {
+                std::fprintf(stderr, "input %d: matcher says %d, compiler says %d\n", i, !compiled, compiled.has_value());
+                return 1;
+            }
+            compared += 1;
+        }
+        valid += compiled.has_value();
+        total += tokens.size();
+        inputs.emplace_back(std::move(tokens));
+    }
+    std::printf("%zu inputs (%zu valid), %zu verdicts compared, %zu tokens\n", inputs.size(), valid, compared, total);
+
+    size_t matched = 0;
+    auto matcher_ns = ns_per_token(inputs, total, [&](const auto& tokens) {
+        matched += function_matcher.match(tokens);
+    });
+    auto compiler_ns = ns_per_token(inputs, total, [&](const auto& tokens) {
+        std::pmr::vector<size_t> offsets(tokens.size(), 0);
+        matched += meta::runtime::compile_tokens({}, tokens, offsets).has_value();
+    });
+    std::printf("%-24s %8.2f ns/token\n", "matcher (function)", matcher_ns);
+    std::printf("%-24s %8.2f ns/token\n", "compile_tokens", compiler_ns);
+
+    std::vector<std::vector<Token>> messages;
+    size_t message_total = 0;
+    for (int i = 0; i < 20000; ++i) {
+        std::string source = "{";
+        for (auto fields = rng() % 16; fields > 0; --fields) {
+            source += " field" + std::to_string(rng() % 100) + " => " + std::to_string(rng()) + ";";
+        }
+        source += " }";
+        auto tokens = tokens_of(source);
+        if (i % 2 == 1) {
+            tokens = mutate(std::move(tokens), rng);
+        }
+        if (message_matcher.match(tokens) != is_message(tokens)) {
+            std::fprintf(stderr, "message %d: matcher says %d\n", i, !is_message(tokens));
+            return 1;
+        }
+        message_total += tokens.size();
+        messages.emplace_back(std::move(tokens));
+    }
+    auto message_ns = ns_per_token(messages, message_total, [&](const auto& tokens) {
+        matched += message_matcher.match(tokens);
+    });
+    std::printf("%-24s %8.2f ns/token\n", "matcher (message)", message_ns);
+    return matched > 0 ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+#include "meta/meta_rules.hpp"
+#include "meta/runtime/batch.hpp"
+#include "meta/runtime/cache.hpp"
+#include "meta/runtime/incremental.hpp"
+#include "meta/runtime/matcher.hpp"
+#include "meta/runtime/parallel.hpp"
+
+using Message = macro_rules({ $($key:ident => $value:number ;)* });
+using meta::runtime::Value;
+
+static auto make_formulas(size_t count) -> std::vector<std::string> {
+    static constexpr const char* ops[] = {" + ", " - ", " * ", " / "};
+
+    std::mt19937 rng(9);
+    std::vector<std::string> formulas;
+    for (size_t i = 0; i < count; ++i) {
+        auto source = std::string("(a b c) -> (") + std::to_string(i + 1);
+        for (auto terms = 2 + rng() % 10; terms > 0; --terms) {
+            source += ops[rng() % 4];
+            source += "abc"[rng() % 3];
+        }
+        // every 16th formula is broken, so failures show up too
+        source += i % 16 == 15 ? " +" : ")";
+        formulas.emplace_back(std::move(source));
+    }
+    return formulas;
+}
+
+/** compiles, caches, evaluates and matches a fixed mix, returns how long it took **/
+static auto run(const std::vector<std::string>& formulas, size_t lookups, int64_t& sum) -> double {
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::string_view> views(formulas.begin(), formulas.end());
+    auto compiled = meta::runtime::parse_all(views);
+
+    meta::runtime::ProgramCache cache(formulas.size());
+    std::mt19937 rng(1);
+    std::geometric_distribution<size_t> pick(0.01);
+    Value args[] = {7, 3, 5};
+    for (size_t i = 0; i < lookups; ++i) {
+        if (auto program = cache.get_or_compile(formulas[pick(rng) % formulas.size()])) {
+            sum += (**program)(args);
+        }
+    }
+
+    std::vector<Value> column(4096, 3);
+    std::span<const Value> columns[] = {column, column, column};
+    std::vector<Value> out(column.size());
+    for (const auto& result : compiled) {
+        if (result) {
+            meta::runtime::evaluate_batch(result->view(), columns, out);
+            sum += out.back();
+        }
+    }
+
+    meta::runtime::Matcher matcher(meta::runtime::match_table<Message>);
+    for (size_t i = 0; i < lookups / 10; ++i) {
+        std::vector<Token> tokens;
+        meta::runtime::scan_tokens("{ price => 10; quantity => " + std::to_string(i) + "; }", [&](Token tk, size_t) {
+            tokens.emplace_back(tk);
+        });
+        sum += matcher.match(tokens);
+    }
+
+    for (size_t i = 0; i < formulas.size(); i += 8) {
+        meta::runtime::IncrementalCompiler incremental;
+        const auto& source = formulas[i];
+        incremental.feed(std::string_view(source).substr(0, source.size() / 2));
+        incremental.feed(std::string_view(source).substr(source.size() / 2));
+        sum += incremental.finish().has_value();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static constexpr const char* opcode_names[] = {
+    "Load", "Const", "Neg", "Not", "BitNot", "Add", "Sub", "Mul", "Div", "Less", "LessEqual", "Greater", "GreaterEqual",
+};
+
+auto main(int argc, char** argv) -> int {
+    auto formulas = make_formulas(argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4000);
+    auto lookups = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 200'000;
+
+    int64_t sum = 0;
+    auto best = run(formulas, lookups, sum);
+    for (int repeat = 0; repeat < 4; ++repeat) {
+        best = std::min(best, run(formulas, lookups, sum));
+    }
+    std::printf("metrics %s: workload %.2f ms (best of 5)\n", meta::runtime::metrics_enabled ? "on" : "off", best);
+
+    auto start = std::chrono::steady_clock::now();
+    auto snapshot = meta::runtime::metrics_snapshot();
+    auto snapshot_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    if (!meta::runtime::metrics_enabled) {
+        return sum != 0 ? 0 : 1;
+    }
+    std::printf("snapshot took %.1f us\n\n", snapshot_us);
+
+    std::printf("%-12s %10s %9s %10s %10s %10s %10s %14s\n", "grammar", "parses", "failures", "mean ns", "p50 ns", "p99 ns", "max ns", "tokens/s");
+    for (size_t g = 0; g < meta::runtime::grammar_count; ++g) {
+        const auto& metrics = snapshot.grammars[g];
+        const auto& latency = metrics.latency;
+        std::printf("%-12s %10llu %9llu %10.0f %10llu %10llu %10llu %14.0f\n", meta::runtime::grammar_name(meta::runtime::Grammar(g)),
+                    (unsigned long long) latency.count, (unsigned long long) metrics.failures, latency.mean(),
+                    (unsigned long long) latency.percentile(0.5), (unsigned long long) latency.percentile(0.99),
+                    (unsigned long long) latency.max, metrics.tokens_per_second());
+    }
+    std::printf("\narena bytes %llu, cache hit rate %.2f%% (%llu hits, %llu misses), %llu evaluations\n",
+                (unsigned long long) snapshot.arena_bytes, 100.0 * snapshot.cache_hit_rate(), (unsigned long long) snapshot.cache_hits,
+                (unsigned long long) snapshot.cache_misses, (unsigned long long) snapshot.evaluations);
+    for (size_t op = 0; op < std::size(opcode_names); ++op) {
+        std::printf("  %-14s %14llu\n", opcode_names[op], (unsigned long long) snapshot.opcodes[op]);
+    }
+    return sum != 0 ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+#include "meta/runtime/parallel.hpp"
+
+static auto make_snippets(size_t count) -> std::vector<std::string> {
+    static constexpr const char* ops[] = {"+", "-", "*", "/"};
+
+    std::mt19937 rng(11);
+    std::vector<std::string> snippets;
+    for (size_t i = 0; i < count; ++i) {
+        auto source = std::string("(x y z w) -> ((") + std::to_string(i % 1000);
+        auto terms = 8 + rng() % 24;
+        for (size_t term = 0; term < terms; ++term) {
+            source += ' ';
+            source += ops[rng() % 4];
+            source += term % 5 == 4 ? " (" : " ";
+            source += "xyzw"[rng() % 4];
+            source += term % 5 == 4 ? " * 3)" : "";
+        }
+        source += " < z * 2))";
+        // every 20th snippet is broken to exercise error reporting
+        if (i % 20 == 0) {
+            source += rng() % 2 ? " +" : " q";
+        }
+        snippets.emplace_back(std::move(source));
+    }
+    return snippets;
+}
+
+static auto same(const meta::runtime::CompileResult& lhs, const meta::runtime::CompileResult& rhs) -> bool {
+    if (lhs.has_value() != rhs.has_value()) {
+        return false;
+    }
+    if (!lhs) {
+        return lhs.error().offset == rhs.error().offset && lhs.error().message == rhs.error().message;
+    }
+    return lhs->params == rhs->params
+        && lhs->constants == rhs->constants
+        && lhs->stack_size == rhs->stack_size
+        && std::equal(lhs->code.begin(), lhs->code.end(), rhs->code.begin(), rhs->code.end(), [](auto a, auto b) {
+            return a.op == b.op && a.arg == b.arg;
+        });
+}
+
+auto main(int argc, char** argv) -> int {
+    auto count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 50'000;
+    auto max_threads = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : std::max(1u, std::thread::hardware_concurrency());
+
+    auto storage = make_snippets(count);
+    std::vector<std::string_view> snippets(storage.begin(), storage.end());
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<meta::runtime::CompileResult> expected;
+    for (auto snippet : snippets) {
+        expected.emplace_back(meta::runtime::compile(snippet));
+    }
+    auto sequential = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    auto failures = std::count_if(expected.begin(), expected.end(), [](const auto& r) { return !r; });
+    std::printf("%zu snippets, %zu with errors\n", snippets.size(), size_t(failures));
+    std::printf("%-10s %10s %10s %12s\n", "threads", "ms", "speedup", "snippets/s");
+    std::printf("%-10s %10.2f %10.2f %12.0f\n", "sequential", sequential * 1e3, 1.0, double(count) / sequential);
+
+    double single = 0;
+    for (size_t threads = 1; threads <= max_threads; threads = threads < max_threads ? std::min<size_t>(threads * 2, max_threads) : threads + 1) {
+        meta::runtime::WorkStealingPool pool(threads);
+
+        start = std::chrono::steady_clock::now();
+        auto results = meta::runtime::parse_all(snippets, pool);
+        auto time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (threads == 1) {
+            single = time;
+        }
+
+        for (size_t i = 0; i < results.size(); ++i) {
+            if (!same(results[i], expected[i])) {
+                std::fprintf(stderr, "result %zu differs from the sequential compile\n", i);
+                return 1;
+            }
+        }
+        std::printf("%-10zu %10.2f %10.2f %12.0f\n", threads, time * 1e3, single / time, double(count) / time);
+    }
+    return 0;
+}
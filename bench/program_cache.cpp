@@ -0,0 +1,110 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "meta/runtime/cache.hpp"
+
+using meta::runtime::Value;
+
+static auto make_formulas(size_t count) -> std::vector<std::string> {
+    static constexpr const char* ops[] = {"+", "-", "*"};
+
+    std::mt19937 rng(7);
+    std::vector<std::string> formulas;
+    for (size_t i = 0; i < count; ++i) {
+        auto source = std::string("(a b c) -> ") + std::to_string(i);
+        for (int term = 0; term < 6; ++term) {
+            source += ' ';
+            source += ops[rng() % 3];
+            source += ' ';
+            source += "abc"[rng() % 3];
+        }
+        formulas.emplace_back(std::move(source));
+    }
+    return formulas;
+}
+
+/** a cached error must report the offset compile() gives for the spelling that was looked up **/
+static auto check_errors() -> bool {
+    std::string deep = "(a) -> a";
+    for (int i = 0; i < 600; ++i) {
+        deep = "(a) -> a - (" + deep.substr(7) + ")";
+    }
+    const std::string sources[] = {"(a b) -> a +", "(a b) -> a + * b", "(a) -> b", "(a) -> a )", deep};
+
+    meta::runtime::ProgramCache cache(16);
+    for (const auto& source : sources) {
+        // the first lookup compiles, the others hit the cached error with a different spelling
+        for (auto indent : {"", "   ", "\n\t "}) {
+            auto spelling = indent + source;
+            auto expected = meta::runtime::compile(spelling);
+            auto cached = cache.get_or_compile(spelling);
+            if (expected || cached || expected.error().offset != cached.error().offset || expected.error().message != cached.error().message) {
+                std::fprintf(stderr, "cached error differs from compile() for \"%.40s\"\n", spelling.c_str());
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/** every thread looks up formulas with a skewed distribution, like a service with a few hot formulas **/
+static auto run(meta::runtime::ProgramCache* cache, const std::vector<std::string>& formulas, size_t threads, size_t lookups) -> double {
+    std::vector<std::thread> workers;
+    std::atomic<int64_t> checksum{0};
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            std::mt19937 rng(static_cast<uint32_t>(t));
+            std::geometric_distribution<size_t> pick(0.002);
+            int64_t sum = 0;
+            Value args[] = {1, 2, 3};
+            for (size_t i = 0; i < lookups; ++i) {
+                const auto& source = formulas[pick(rng) % formulas.size()];
+                if (cache != nullptr) {
+                    sum += (**cache->get_or_compile(source))(args);
+                } else {
+                    sum += (*meta::runtime::compile(source))(args);
+                }
+            }
+            checksum += sum;
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    auto time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return double(threads * lookups) / time;
+}
+
+auto main(int argc, char** argv) -> int {
+    auto formulas = make_formulas(argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4000);
+    auto lookups = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 200'000;
+    auto max_threads = std::max<size_t>(4, std::thread::hardware_concurrency());
+    if (!check_errors()) {
+        return 1;
+    }
+
+    std::printf("%zu formulas, %zu lookups per thread\n", formulas.size(), size_t(lookups));
+    std::printf("%-8s %-10s %14s %10s %10s %10s\n", "threads", "mode", "lookups/s", "hit rate", "misses", "evictions");
+
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        auto uncached = run(nullptr, formulas, threads, lookups / 10);
+        std::printf("%-8zu %-10s %14.0f\n", threads, "compile", uncached);
+
+        for (auto capacity : {formulas.size(), formulas.size() / 4}) {
+            meta::runtime::ProgramCache cache(capacity);
+            auto rate = run(&cache, formulas, threads, lookups);
+            auto stats = cache.stats();
+            auto mode = capacity == formulas.size() ? "cache" : "cache/4";
+            std::printf("%-8zu %-10s %14.0f %9.2f%% %10llu %10llu\n", threads, mode, rate,
+                        100.0 * double(stats.hits) / double(stats.hits + stats.misses),
+                        (unsigned long long) stats.misses, (unsigned long long) stats.evictions);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+
+#include "meta/runtime/compiler.hpp"
+#include "meta/runtime/image.hpp"
+
+using Clock = std::chrono::steady_clock;
+using meta::runtime::Value;
+
+/** one `name = formula` per line, the shape a formula library would have on disk **/
+static auto make_library(size_t count) -> std::string {
+    static constexpr const char* ops[] = {" + ", " - ", " * "};
+    static constexpr const char* params[] = {"price", "quantity", "discount", "tax"};
+
+    std::mt19937 rng(5);
+    std::string library;
+    for (size_t i = 0; i < count; ++i) {
+        library += "formula_" + std::to_string(i) + " = (price quantity discount tax) -> " + std::to_string(rng() % 100);
+        for (auto terms = 4 + rng() % 12; terms > 0; --terms) {
+            library += ops[rng() % 3];
+            library += params[rng() % 4];
+        }
+        library += '\n';
+    }
+    return library;
+}
+
+static auto write_file(const char* path, std::string_view content) -> bool {
+    auto* file = std::fopen(path, "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    auto ok = std::fwrite(content.data(), 1, content.size(), file) == content.size();
+    return std::fclose(file) == 0 && ok;
+}
+
+template<typename Fn>
+static auto for_each_line(std::string_view text, Fn&& fn) {
+    while (!text.empty()) {
+        auto end = text.find('\n');
+        auto line = text.substr(0, end);
+        auto eq = line.find(" = ");
+        fn(line.substr(0, eq), line.substr(eq + 3));
+        text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+    }
+}
+
+static auto elapsed(Clock::time_point start) -> double {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+auto main(int argc, char** argv) -> int {
+    auto count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20'000;
+    auto library = make_library(count);
+    auto source_path = "program_image.txt";
+    auto image_path = "program_image.bin";
+    if (!write_file(source_path, library)) {
+        std::fprintf(stderr, "cannot write %s\n", source_path);
+        return 1;
+    }
+
+    std::vector<std::string> names;
+    std::vector<meta::runtime::Program> programs;
+    for_each_line(library, [&](std::string_view name, std::string_view source) {
+        names.emplace_back(name);
+        programs.emplace_back(*meta::runtime::compile(source));
+    });
+    std::vector<meta::runtime::NamedProgram> named;
+    for (size_t i = 0; i < programs.size(); ++i) {
+        named.push_back({names[i], programs[i]});
+    }
+    if (auto saved = meta::runtime::save_image(image_path, named); !saved) {
+        std::fprintf(stderr, "%.*s: %s\n", int(saved.error().message.size()), saved.error().message.data(), saved.error().code.message().c_str());
+        return 1;
+    }
+
+    // a flipped byte in the body is caught by the checksum
+    auto image = meta::runtime::build_image(named);
+    image[image.size() / 2] ^= std::byte{1};
+    if (meta::runtime::ProgramImage::load(image).error().message != std::string_view("checksum mismatch")) {
+        std::fprintf(stderr, "corruption was not detected\n");
+        return 1;
+    }
+
+    // a valid checksum does not make the bytecode safe to run, load() checks every program before evaluate() sees it
+    auto rejects = [](const char* what, const meta::runtime::Program& program) {
+        meta::runtime::NamedProgram bad[] = {{"bad", program}};
+        auto image = meta::runtime::build_image(bad);
+        auto loaded = meta::runtime::ProgramImage::load(image);
+        if (loaded || loaded.error().message != std::string_view("corrupted image")) {
+            std::fprintf(stderr, "%s was not rejected\n", what);
+            return false;
+        }
+        return true;
+    };
+    using meta::runtime::OpCode;
+    auto bytecode = [](std::vector<meta::runtime::Instruction> code, uint32_t stack_size) {
+        return meta::runtime::Program{{"a"}, std::move(code), {1}, stack_size};
+    };
+    auto overflow = bytecode({}, 1);
+    overflow.code.assign(600, {OpCode::Const});
+    if (!rejects("stack overflow", overflow)
+        || !rejects("stack underflow", bytecode({{OpCode::Load}, {OpCode::Add}}, 2))
+        || !rejects("unknown opcode", bytecode({{OpCode(0xFF)}}, 1))
+        || !rejects("argument out of range", bytecode({{OpCode::Load, {}, 1}}, 1))
+        || !rejects("constant out of range", bytecode({{OpCode::Const, {}, 1}}, 1))
+        || !rejects("leftover values", bytecode({{OpCode::Load}, {OpCode::Const}}, 2))
+        || !rejects("empty code", bytecode({}, 0))) {
+        return 1;
+    }
+
+    // two fixed programs, so the checks below do not depend on how many formulas were asked for
+    auto first = *meta::runtime::compile("(a) -> a + 1");
+    auto second = *meta::runtime::compile("(a) -> a * 2");
+    meta::runtime::NamedProgram pair[] = {{"one", first}, {"two", second}};
+
+    // the checksum covers the header, dropping the last entry from both counts must not hide "two"
+    auto truncated = meta::runtime::build_image(pair);
+    meta::runtime::detail::ImageHeader header;
+    std::memcpy(&header, truncated.data(), sizeof(header));
+    header.count -= 1;
+    header.entries.count -= 1;
+    std::memcpy(truncated.data(), &header, sizeof(header));
+    if (auto loaded = meta::runtime::ProgramImage::load(truncated); loaded || loaded.error().message != std::string_view("checksum mismatch")) {
+        std::fprintf(stderr, "header corruption was not detected\n");
+        return 1;
+    }
+
+    // swapping two entries keeps every range valid, but find() would miss names
+    auto swapped = meta::runtime::build_image(pair);
+    auto* entries = swapped.data() + sizeof(meta::runtime::detail::ImageHeader);
+    std::swap_ranges(entries, entries + sizeof(meta::runtime::detail::ImageEntry), entries + sizeof(meta::runtime::detail::ImageEntry));
+    if (auto loaded = meta::runtime::ProgramImage::load(swapped, false); loaded || loaded.error().message != std::string_view("corrupted image")) {
+        std::fprintf(stderr, "unsorted entries were not rejected\n");
+        return 1;
+    }
+
+    Value args[] = {19, 3, 2, 5};
+    std::vector<Value> expected;
+    for (const auto& program : programs) {
+        expected.push_back(program(args));
+    }
+
+    // startup from source: read the library, compile every formula, evaluate each once
+    auto start = Clock::now();
+    auto mapped = meta::runtime::MappedFile::open(source_path);
+    std::vector<meta::runtime::Program> compiled;
+    compiled.reserve(count);
+    for_each_line(mapped->view(), [&](std::string_view, std::string_view source) {
+        compiled.emplace_back(*meta::runtime::compile(source));
+    });
+    int64_t sum = 0;
+    for (const auto& program : compiled) {
+        sum += program(args);
+    }
+    auto source_ms = elapsed(start);
+
+    // startup from the image: map it, look every formula up by name, evaluate each once
+    auto startup = [&](bool verify, double& ms) -> bool {
+        auto start = Clock::now();
+        auto loaded = meta::runtime::ProgramImage::open(image_path, verify);
+        if (!loaded) {
+            std::fprintf(stderr, "%.*s\n", int(loaded.error().message.size()), loaded.error().message.data());
+            return false;
+        }
+        for (size_t i = 0; i < names.size(); ++i) {
+            auto program = loaded->find(names[i]);
+            if (!program || (*program)(args) != expected[i] || program->param(3) != "tax") {
+                std::fprintf(stderr, "%s differs from the compiled program\n", names[i].c_str());
+                return false;
+            }
+        }
+        ms = elapsed(start);
+        return true;
+    };
+    double verified_ms = 0;
+    double unverified_ms = 0;
+    if (!startup(true, verified_ms) || !startup(false, unverified_ms)) {
+        return 1;
+    }
+
+    std::printf("%zu formulas, %zu bytes of source, %zu byte image\n", names.size(), library.size(), image.size());
+    std::printf("%-24s %10.2f ms\n", "from source", source_ms);
+    std::printf("%-24s %10.2f ms\n", "from image", verified_ms);
+    std::printf("%-24s %10.2f ms\n", "from image, no checksum", unverified_ms);
+    std::remove(source_path);
+    std::remove(image_path);
+    return sum != 0 ? 0 : 1;
+}
@@ -0,0 +1,71 @@
+#
+# meta_embed_files(<target> [HEADER <name>] FILES <file>...)
+#
+# Generates <name> (default meta_embedded_files.hpp) on the include path of <target>. Including it makes
+# every file available to apply_rules_file(Rules, "<file>"), with <file> spelled exactly as given here.
+# Compilers with #embed read the files directly, others get their bytes written out by this script
+# at build time, regenerated whenever a file changes.
+#
+
+# script mode, writes the header
+if (CMAKE_SCRIPT_MODE_FILE STREQUAL CMAKE_CURRENT_LIST_FILE)
+    string(REPLACE "|" ";" KEYS "${KEYS}")
+    string(REPLACE "|" ";" PATHS "${PATHS}")
+    set(content "// generated by meta_embed_files(), do not edit\n#pragma once\n\n#include \"meta/embed.hpp\"\n\nnamespace meta::parse {\n")
+    foreach(key path IN ZIP_LISTS KEYS PATHS)
+        string(APPEND content "    template<>\n    struct embedded_file<\"${key}\"> {\n        static constexpr unsigned char bytes[] = {\n")
+        if (EMBED)
+            string(APPEND content "#embed \"${path}\" suffix(,)\n")
+        else()
+            file(READ "${path}" hex HEX)
+            # 16 bytes per line
+            string(REGEX REPLACE "([0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f])" "\\1\n" hex "${hex}")
+            string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," hex "${hex}")
+            string(REPLACE "\n" "\n            " hex "${hex}")
+            string(APPEND content "            ${hex}\n")
+        endif()
+        string(APPEND content "            0\n        };\n    };\n\n")
+    endforeach()
+    string(APPEND content "}\n")
+    file(WRITE "${OUTPUT}" "${content}")
+    return()
+endif()
+
+include_guard(GLOBAL)
+include(CheckCXXSourceCompiles)
+
+function(meta_embed_files target)
+    cmake_parse_arguments(PARSE_ARGV 1 ARG "" "HEADER" "FILES")
+    if (NOT ARG_HEADER)
+        set(ARG_HEADER meta_embedded_files.hpp)
+    endif()
+    check_cxx_source_compiles("
+        #if !defined(__has_embed)
+        #error no #embed
+        #endif
+        int main() {}" META_HAS_EMBED)
+
+    set(keys)
+    set(paths)
+    foreach(file IN LISTS ARG_FILES)
+        get_filename_component(path "${file}" ABSOLUTE)
+        list(APPEND keys "${file}")
+        list(APPEND paths "${path}")
+    endforeach()
+    # the script gets the lists as single arguments
+    list(JOIN keys "|" keys)
+    list(JOIN paths "|" joined_paths)
+
+    # this file doubles as the generator script
+    set(script "${CMAKE_CURRENT_FUNCTION_LIST_FILE}")
+    set(directory "${CMAKE_CURRENT_BINARY_DIR}/${target}_embedded_files")
+    set(header "${directory}/${ARG_HEADER}")
+    add_custom_command(
+        OUTPUT "${header}"
+        COMMAND "${CMAKE_COMMAND}" "-DOUTPUT=${header}" "-DKEYS=${keys}" "-DPATHS=${joined_paths}" "-DEMBED=${META_HAS_EMBED}" -P "${script}"
+        DEPENDS ${paths} "${script}"
+        COMMENT "Embedding grammar sources for ${target}"
+        VERBATIM)
+    target_sources(${target} PRIVATE "${header}")
+    target_include_directories(${target} PRIVATE "${directory}")
+endfunction()
@@ -0,0 +1,66 @@
+#
+# meta_grammar_units(<target> DEFINITIONS <file> [UNITS <count>] [PREAMBLE <header>...])
+#
+# Splits a file of grammar blocks into <count> generated translation units and adds them to <target>,
+# so heavy apply_rules / META_DEFINE blocks are evaluated once and compile in parallel.
+#
+# Blocks are separated by blank lines and are distributed round-robin, so they must not depend on
+# each other; shared grammars and the META_DECLARE header go into PREAMBLE, which every unit includes.
+# UNITS defaults to the number of logical cores. Errors point back into the definitions file.
+#
+function(meta_grammar_units target)
+    cmake_parse_arguments(PARSE_ARGV 1 ARG "" "DEFINITIONS;UNITS" "PREAMBLE")
+    if (NOT ARG_DEFINITIONS)
+        message(FATAL_ERROR "meta_grammar_units(${target}): DEFINITIONS is required")
+    endif()
+    if (NOT ARG_UNITS)
+        cmake_host_system_information(RESULT ARG_UNITS QUERY NUMBER_OF_LOGICAL_CORES)
+    endif()
+
+    get_filename_component(definitions "${ARG_DEFINITIONS}" ABSOLUTE)
+    set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS "${definitions}")
+    file(READ "${definitions}" content)
+
+    # `;` and brackets mean something to CMake lists, hide them while splitting
+    string(REPLACE ";" "<meta-semicolon>" content "${content}")
+    string(REPLACE "[" "<meta-open-bracket>" content "${content}")
+    string(REPLACE "]" "<meta-close-bracket>" content "${content}")
+    string(REGEX REPLACE "\n[ \t\r]*\n" "\n;" blocks "${content}")
+
+    set(preamble "// generated by meta_grammar_units() from ${definitions}, do not edit\n")
+    foreach(header IN LISTS ARG_PREAMBLE)
+        get_filename_component(header "${header}" ABSOLUTE)
+        string(APPEND preamble "#include \"${header}\"\n")
+    endforeach()
+
+    set(line 1)
+    set(index 0)
+    foreach(block IN LISTS blocks)
+        string(STRIP "${block}" stripped)
+        if (NOT stripped STREQUAL "")
+            math(EXPR unit "${index} % ${ARG_UNITS}")
+            string(APPEND unit_${unit} "#line ${line} \"${definitions}\"\n${block}\n")
+            math(EXPR index "${index} + 1")
+        endif()
+        # the separator took one newline of the blank line with it
+        string(REGEX MATCHALL "\n" newlines "${block}")
+        list(LENGTH newlines count)
+        math(EXPR line "${line} + ${count} + 1")
+    endforeach()
+
+    set(directory "${CMAKE_CURRENT_BINARY_DIR}/${target}_grammar_units")
+    set(sources)
+    math(EXPR last "${ARG_UNITS} - 1")
+    foreach(unit RANGE ${last})
+        set(source "${preamble}${unit_${unit}}")
+        string(REPLACE "<meta-semicolon>" ";" source "${source}")
+        string(REPLACE "<meta-open-bracket>" "[" source "${source}")
+        string(REPLACE "<meta-close-bracket>" "]" source "${source}")
+
+        # rewrite only what changed, untouched units are not rebuilt
+        file(WRITE "${directory}/unit_${unit}.cpp.in" "${source}")
+        configure_file("${directory}/unit_${unit}.cpp.in" "${directory}/unit_${unit}.cpp" COPYONLY)
+        list(APPEND sources "${directory}/unit_${unit}.cpp")
+    endforeach()
+    target_sources(${target} PRIVATE ${sources})
+endfunction()
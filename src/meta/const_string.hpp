@@ -4,11 +4,14 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <string_view>
 
 template<size_t N>
 struct const_string : std::array<char, N> {
-    constexpr const_string(const char(&chars)[N]) {
+    constexpr const_string(const char(&chars)[N]) : std::array<char, N>{} {
         std::copy_n(chars, N, std::array<char, N>::begin());
     }
 
@@ -0,0 +1,40 @@
+//
+// Created by Maksym Pasichnyk on 19.10.2026.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+
+#include "meta.hpp"
+
+namespace meta::parse {
+    /**
+     * Contents of a file registered with meta_embed_files() in CMake. The generated header specializes it
+     * for every registered path with `static constexpr unsigned char bytes[]`, the file followed by a null byte,
+     * filled by #embed where the compiler has it and by a generated byte list otherwise.
+     **/
+    template<const_string path>
+    struct embedded_file;
+
+    /** #embed yields values in 0..255, which do not narrow into `char` **/
+    template<const_string path>
+    inline constexpr auto embedded_text = [] {
+        constexpr auto& bytes = embedded_file<path>::bytes;
+        std::array<char, std::size(bytes)> text{};
+        std::transform(std::begin(bytes), std::end(bytes), text.begin(), [](unsigned char c) {
+            return static_cast<char>(c);
+        });
+        return text;
+    }();
+
+    template<typename T, const_string path>
+    consteval auto compile_file() {
+        return detail::__parse<T, [] { return std::string_view(embedded_text<path>.data(), embedded_text<path>.size() - 1); }>();
+    }
+}
+
+/** like apply_rules, but the source is read from `path` instead of going through the preprocessor **/
+#define apply_rules_file(rules, path) meta::parse::compile_file<rules, path>()
@@ -75,8 +75,10 @@ struct UnaryExpression {
         }
     };
 
+    using rule = meta::parse::one_of<prefix, PrimitiveExpression>;
+
     consteval static auto compile(auto stream) {
-        return meta::parse::one_of<prefix, PrimitiveExpression>::compile(stream);
+        return rule::compile(stream);
     }
 };
 
@@ -105,8 +107,10 @@ struct MultiplicationExpression {
         }
     };
 
+    using rule = meta::parse::one_of<infix, UnaryExpression>;
+
     consteval static auto compile(auto stream) {
-        return meta::parse::one_of<infix, UnaryExpression>::compile(stream);
+        return rule::compile(stream);
     }
 };
 
@@ -135,8 +139,10 @@ struct AdditionExpression {
         }
     };
 
+    using rule = meta::parse::one_of<infix, MultiplicationExpression>;
+
     consteval static auto compile(auto stream) {
-        return meta::parse::one_of<infix, MultiplicationExpression>::compile(stream);
+        return rule::compile(stream);
     }
 };
 
@@ -153,9 +159,11 @@ struct ComparisonExpression {
     >> {
         consteval static auto transform(auto ctx) {
             return [] (auto ctx_, const auto& args) {
-                constexpr auto op = std::get<1>(decltype(ctx){}.value());
-                auto lhs = std::get<0>(decltype(ctx){}.value())(ctx_, args);
-                auto rhs = std::get<2>(decltype(ctx){}.value())(ctx_, args);
+                // value is `( group )`, the operands live in the inner group
+                constexpr auto group = std::get<1>(decltype(ctx){}.value());
+                constexpr auto op = std::get<1>(group);
+                auto lhs = std::get<0>(group)(ctx_, args);
+                auto rhs = std::get<2>(group)(ctx_, args);
 
                 if constexpr (op.is(TokenType::LessThan)) {
                     return lhs < rhs;
@@ -173,8 +181,10 @@ struct ComparisonExpression {
         }
     };
 
+    using rule = meta::parse::one_of<infix, AdditionExpression>;
+
     consteval static auto compile(auto stream) {
-        return meta::parse::one_of<infix, AdditionExpression>::compile(stream);
+        return rule::compile(stream);
     }
 };
 
@@ -193,21 +193,32 @@ namespace meta::parse {
         }
     };
 
-    template<typename T, const_string chars>
-    consteval auto compile() {
-        auto stream = Wrapper<[] { return TokenStream::parse(chars.str()); }>{};
-        auto r = Wrapper<[] { return detail::__compile<T>(decltype(stream){}); }>{};
-        if constexpr (r.value()) {
-            if constexpr (stream.value().at(r.value().current).token().is(TokenType::End)) {
-                return r.value().value;
+    namespace detail {
+        /** tokens of the text returned by `source`, sized to fit it exactly **/
+        template<auto source>
+        inline constexpr auto __tokens = TokenStream<count_tokens(source()) + 1>::parse(source());
+
+        template<typename T, auto source>
+        consteval auto __parse() {
+            auto stream = Wrapper<[] { return __tokens<source>.cursor(); }>{};
+            auto r = Wrapper<[] { return __compile<T>(decltype(stream){}); }>{};
+            if constexpr (r.value()) {
+                if constexpr (stream.value().at(r.value().current).token().is(TokenType::End)) {
+                    return r.value().value;
+                } else {
+                    return None{};
+                }
             } else {
                 return None{};
             }
-        } else {
-            return None{};
         }
     }
 
+    template<typename T, const_string chars>
+    consteval auto compile() {
+        return detail::__parse<T, [] { return chars.str(); }>();
+    }
+
     /** function to retrieve all fragments with a given name **/
     template<const_string name>
     consteval auto get(const auto& tree) {
@@ -0,0 +1,306 @@
+//
+// Created by Maksym Pasichnyk on 19.10.2026.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+
+#include "isa.hpp"
+#include "program.hpp"
+
+namespace meta::runtime {
+    namespace detail {
+        /** rows evaluated per op, small enough that every live slot stays in L1/L2 **/
+        static constexpr size_t batch_chunk = 1024;
+
+        // every kernel works on `n` rows: out[i] = op(a[i]) or out[i] = op(a[i], b[i]), out may alias a
+        struct ScalarKernels {
+            template<OpCode op>
+            static void unary_loop(const Value* a, Value* out, size_t n) {
+                for (size_t i = 0; i < n; ++i) {
+                    out[i] = apply_unary(op, a[i]);
+                }
+            }
+
+            static void unary(OpCode op, const Value* a, Value* out, size_t n) {
+                switch (op) {
+                    case OpCode::Neg:
+                        return unary_loop<OpCode::Neg>(a, out, n);
+                    case OpCode::Not:
+                        return unary_loop<OpCode::Not>(a, out, n);
+                    case OpCode::BitNot:
+                        return unary_loop<OpCode::BitNot>(a, out, n);
+                    default:
+                        // only unary opcodes reach a unary kernel
+                        assert(false);
+                        return;
+                }
+            }
+
+            template<OpCode op>
+            static void loop(const Value* a, const Value* b, Value* out, size_t n) {
+                for (size_t i = 0; i < n; ++i) {
+                    out[i] = apply_binary(op, a[i], b[i]);
+                }
+            }
+
+            static void binary(OpCode op, const Value* a, const Value* b, Value* out, size_t n) {
+                switch (op) {
+                    case OpCode::Add:
+                        return loop<OpCode::Add>(a, b, out, n);
+                    case OpCode::Sub:
+                        return loop<OpCode::Sub>(a, b, out, n);
+                    case OpCode::Mul:
+                        return loop<OpCode::Mul>(a, b, out, n);
+                    case OpCode::Div:
+                        return loop<OpCode::Div>(a, b, out, n);
+                    case OpCode::Less:
+                        return loop<OpCode::Less>(a, b, out, n);
+                    case OpCode::LessEqual:
+                        return loop<OpCode::LessEqual>(a, b, out, n);
+                    case OpCode::Greater:
+                        return loop<OpCode::Greater>(a, b, out, n);
+                    case OpCode::GreaterEqual:
+                        return loop<OpCode::GreaterEqual>(a, b, out, n);
+                    default:
+                        // only binary opcodes reach a binary kernel
+                        assert(false);
+                        return;
+                }
+            }
+        };
+
+#if META_RUNTIME_X86
+        struct Sse2Kernels {
+            __attribute__((target("sse2")))
+            static auto mullo(__m128i a, __m128i b) -> __m128i {
+                auto even = _mm_mul_epu32(a, b);
+                auto odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+                return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+            }
+
+            template<OpCode op>
+            __attribute__((target("sse2")))
+            static void unary_loop(const Value* a, Value* out, size_t n) {
+                auto zero = _mm_setzero_si128();
+                auto one = _mm_set1_epi32(1);
+                size_t i = 0;
+                for (; i + 4 <= n; i += 4) {
+                    auto va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+                    __m128i r;
+                    if constexpr (op == OpCode::Neg) r = _mm_sub_epi32(zero, va);
+                    if constexpr (op == OpCode::Not) r = _mm_and_si128(_mm_cmpeq_epi32(va, zero), one);
+                    if constexpr (op == OpCode::BitNot) r = _mm_xor_si128(va, _mm_set1_epi32(-1));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), r);
+                }
+                ScalarKernels::unary_loop<op>(a + i, out + i, n - i);
+            }
+
+            static void unary(OpCode op, const Value* a, Value* out, size_t n) {
+                switch (op) {
+                    case OpCode::Neg:
+                        return unary_loop<OpCode::Neg>(a, out, n);
+                    case OpCode::Not:
+                        return unary_loop<OpCode::Not>(a, out, n);
+                    case OpCode::BitNot:
+                        return unary_loop<OpCode::BitNot>(a, out, n);
+                    default:
+                        return ScalarKernels::unary(op, a, out, n);
+                }
+            }
+
+            template<OpCode op>
+            __attribute__((target("sse2")))
+            static void loop(const Value* a, const Value* b, Value* out, size_t n) {
+                auto one = _mm_set1_epi32(1);
+                size_t i = 0;
+                for (; i + 4 <= n; i += 4) {
+                    auto va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+                    auto vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+                    __m128i r;
+                    if constexpr (op == OpCode::Add) r = _mm_add_epi32(va, vb);
+                    if constexpr (op == OpCode::Sub) r = _mm_sub_epi32(va, vb);
+                    if constexpr (op == OpCode::Mul) r = mullo(va, vb);
+                    if constexpr (op == OpCode::Less) r = _mm_and_si128(_mm_cmplt_epi32(va, vb), one);
+                    if constexpr (op == OpCode::LessEqual) r = _mm_andnot_si128(_mm_cmpgt_epi32(va, vb), one);
+                    if constexpr (op == OpCode::Greater) r = _mm_and_si128(_mm_cmpgt_epi32(va, vb), one);
+                    if constexpr (op == OpCode::GreaterEqual) r = _mm_andnot_si128(_mm_cmplt_epi32(va, vb), one);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), r);
+                }
+                ScalarKernels::loop<op>(a + i, b + i, out + i, n - i);
+            }
+
+            static void binary(OpCode op, const Value* a, const Value* b, Value* out, size_t n) {
+                switch (op) {
+                    case OpCode::Add:
+                        return loop<OpCode::Add>(a, b, out, n);
+                    case OpCode::Sub:
+                        return loop<OpCode::Sub>(a, b, out, n);
+                    case OpCode::Mul:
+                        return loop<OpCode::Mul>(a, b, out, n);
+                    case OpCode::Less:
+                        return loop<OpCode::Less>(a, b, out, n);
+                    case OpCode::LessEqual:
+                        return loop<OpCode::LessEqual>(a, b, out, n);
+                    case OpCode::Greater:
+                        return loop<OpCode::Greater>(a, b, out, n);
+                    case OpCode::GreaterEqual:
+                        return loop<OpCode::GreaterEqual>(a, b, out, n);
+                    case OpCode::Div:
+                        // there is no packed integer division
+                        return ScalarKernels::loop<OpCode::Div>(a, b, out, n);
+                    default:
+                        return ScalarKernels::binary(op, a, b, out, n);
+                }
+            }
+        };
+
+        struct Avx2Kernels {
+            template<OpCode op>
+            __attribute__((target("avx2")))
+            static void unary_loop(const Value* a, Value* out, size_t n) {
+                auto zero = _mm256_setzero_si256();
+                auto one = _mm256_set1_epi32(1);
+                size_t i = 0;
+                for (; i + 8 <= n; i += 8) {
+                    auto va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+                    __m256i r;
+                    if constexpr (op == OpCode::Neg) r = _mm256_sub_epi32(zero, va);
+                    if constexpr (op == OpCode::Not) r = _mm256_and_si256(_mm256_cmpeq_epi32(va, zero), one);
+                    if constexpr (op == OpCode::BitNot) r = _mm256_xor_si256(va, _mm256_set1_epi32(-1));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), r);
+                }
+                ScalarKernels::unary_loop<op>(a + i, out + i, n - i);
+            }
+
+            static void unary(OpCode op, const Value* a, Value* out, size_t n) {
+                switch (op) {
+                    case OpCode::Neg:
+                        return unary_loop<OpCode::Neg>(a, out, n);
+                    case OpCode::Not:
+                        return unary_loop<OpCode::Not>(a, out, n);
+                    case OpCode::BitNot:
+                        return unary_loop<OpCode::BitNot>(a, out, n);
+                    default:
+                        return ScalarKernels::unary(op, a, out, n);
+                }
+            }
+
+            template<OpCode op>
+            __attribute__((target("avx2")))
+            static void loop(const Value* a, const Value* b, Value* out, size_t n) {
+                auto one = _mm256_set1_epi32(1);
+                size_t i = 0;
+                for (; i + 8 <= n; i += 8) {
+                    auto va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+                    auto vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+                    __m256i r;
+                    if constexpr (op == OpCode::Add) r = _mm256_add_epi32(va, vb);
+                    if constexpr (op == OpCode::Sub) r = _mm256_sub_epi32(va, vb);
+                    if constexpr (op == OpCode::Mul) r = _mm256_mullo_epi32(va, vb);
+                    if constexpr (op == OpCode::Less) r = _mm256_and_si256(_mm256_cmpgt_epi32(vb, va), one);
+                    if constexpr (op == OpCode::LessEqual) r = _mm256_andnot_si256(_mm256_cmpgt_epi32(va, vb), one);
+                    if constexpr (op == OpCode::Greater) r = _mm256_and_si256(_mm256_cmpgt_epi32(va, vb), one);
+                    if constexpr (op == OpCode::GreaterEqual) r = _mm256_andnot_si256(_mm256_cmpgt_epi32(vb, va), one);
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), r);
+                }
+                ScalarKernels::loop<op>(a + i, b + i, out + i, n - i);
+            }
+
+            static void binary(OpCode op, const Value* a, const Value* b, Value* out, size_t n) {
+                switch (op) {
+                    case OpCode::Add:
+                        return loop<OpCode::Add>(a, b, out, n);
+                    case OpCode::Sub:
+                        return loop<OpCode::Sub>(a, b, out, n);
+                    case OpCode::Mul:
+                        return loop<OpCode::Mul>(a, b, out, n);
+                    case OpCode::Less:
+                        return loop<OpCode::Less>(a, b, out, n);
+                    case OpCode::LessEqual:
+                        return loop<OpCode::LessEqual>(a, b, out, n);
+                    case OpCode::Greater:
+                        return loop<OpCode::Greater>(a, b, out, n);
+                    case OpCode::GreaterEqual:
+                        return loop<OpCode::GreaterEqual>(a, b, out, n);
+                    case OpCode::Div:
+                        return ScalarKernels::loop<OpCode::Div>(a, b, out, n);
+                    default:
+                        return ScalarKernels::binary(op, a, b, out, n);
+                }
+            }
+        };
+#endif
+
+        /**
+         * Stack slot `d` of the interpreter becomes a column of `batch_chunk` rows.
+         * Loads alias the input column directly, constants are broadcast once per call,
+         * everything else is written into scratch.
+         **/
+        template<typename Kernels>
+        void evaluate_batch(const ProgramView& program, std::span<const std::span<const Value>> columns, std::span<Value> out) {
+            std::vector<Value> scratch(static_cast<size_t>(program.stack_size) * batch_chunk);
+            std::vector<Value> broadcast(program.constants.size() * batch_chunk);
+            for (size_t i = 0; i < program.constants.size(); ++i) {
+                std::fill_n(broadcast.data() + i * batch_chunk, batch_chunk, program.constants[i]);
+            }
+            std::array<const Value*, max_stack_size> slots{};
+
+            for (size_t begin = 0; begin < out.size(); begin += batch_chunk) {
+                auto n = std::min(batch_chunk, out.size() - begin);
+                size_t sp = 0;
+                for (const auto& instruction : program.code) {
+                    switch (instruction.op) {
+                        case OpCode::Load:
+                            slots[sp++] = columns[instruction.arg].data() + begin;
+                            break;
+                        case OpCode::Const:
+                            slots[sp++] = broadcast.data() + instruction.arg * batch_chunk;
+                            break;
+                        case OpCode::Neg:
+                        case OpCode::Not:
+                        case OpCode::BitNot: {
+                            auto* buffer = scratch.data() + (sp - 1) * batch_chunk;
+                            Kernels::unary(instruction.op, slots[sp - 1], buffer, n);
+                            slots[sp - 1] = buffer;
+                            break;
+                        }
+                        default: {
+                            sp -= 1;
+                            auto* buffer = scratch.data() + (sp - 1) * batch_chunk;
+                            Kernels::binary(instruction.op, slots[sp - 1], slots[sp], buffer, n);
+                            slots[sp - 1] = buffer;
+                            break;
+                        }
+                    }
+                }
+                std::copy_n(slots[0], n, out.data() + begin);
+            }
+            detail::record_evaluation(program.code, out.size());
+        }
+    }
+
+    /**
+     * Evaluates the program for every row: out[i] = program(columns[0][i], columns[1][i], ...).
+     * There is one column per parameter, each at least out.size() rows long.
+     * Results are identical to the scalar `evaluate` whatever instruction set is used.
+     **/
+    inline void evaluate_batch(const ProgramView& program, std::span<const std::span<const Value>> columns, std::span<Value> out, Isa isa = best_isa()) {
+        assert(columns.size() == program.arity);
+        assert(std::all_of(columns.begin(), columns.end(), [&](auto column) { return column.size() >= out.size(); }));
+
+        switch (isa) {
+#if META_RUNTIME_X86
+            case Isa::Avx2:
+                return detail::evaluate_batch<detail::Avx2Kernels>(program, columns, out);
+            case Isa::Sse42:
+            case Isa::Sse2:
+                return detail::evaluate_batch<detail::Sse2Kernels>(program, columns, out);
+#endif
+            default:
+                return detail::evaluate_batch<detail::ScalarKernels>(program, columns, out);
+        }
+    }
+}
@@ -0,0 +1,264 @@
+//
+// Created by Maksym Pasichnyk on 19.10.2026.
+//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include "compiler.hpp"
+
+namespace meta::runtime {
+    struct CacheStats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        uint64_t size = 0;
+    };
+
+    namespace detail {
+        /** fnv1a over the token stream, identifiers already carry their fnv1a hash as id **/
+        inline auto hash_tokens(std::span<const Token> tokens) -> uint64_t {
+            uint64_t hash = 0xCBF29CE484222325;
+            for (const auto& tk : tokens) {
+                hash ^= static_cast<uint64_t>(tk.type);
+                hash *= 0x100000001B3;
+                hash ^= static_cast<uint64_t>(tk.id);
+                hash *= 0x100000001B3;
+            }
+            return hash;
+        }
+
+        struct NormalizedSource {
+            std::vector<Token> tokens;
+            std::vector<size_t> offsets;
+        };
+
+        /** tokens of `source` and where they start, in a per-thread buffer reused by every lookup **/
+        inline auto normalize(std::string_view source) -> const NormalizedSource& {
+            thread_local NormalizedSource normalized;
+            normalized.tokens.clear();
+            normalized.offsets.clear();
+            scan_tokens(source, [&](Token tk, size_t offset) {
+                normalized.tokens.emplace_back(tk);
+                normalized.offsets.emplace_back(offset);
+            });
+            return normalized;
+        }
+
+        inline auto same_tokens(std::span<const Token> lhs, std::span<const Token> rhs) -> bool {
+            return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const Token& a, const Token& b) {
+                return a.type == b.type && a.id == b.id;
+            });
+        }
+    }
+
+    /**
+     * Concurrent cache from source text to compiled programs.
+     *
+     * Sources are normalized by tokenizing them, so formulas that differ only in whitespace share an entry.
+     * Every shard publishes an immutable, hash-sorted snapshot through std::atomic<std::shared_ptr>; readers
+     * load it without taking the shard's write mutex and writers copy, modify and republish it. Loading is not
+     * lock-free: libstdc++ guards the pointer with an internal lock bit, and every lookup adjusts the reference
+     * counts of the snapshot and the entry it returns. Recency is tracked per entry with the shard epoch, which
+     * only advances on writes, so a hit stores nothing besides those counts and the entry it touched.
+     *
+     * Failed compilations are cached too, so a hot malformed formula is not compiled again on every lookup.
+     * An error found at a token keeps its token index and is mapped back onto the source of each lookup,
+     * any other error offset is reported as compile() gave it.
+     *
+     * The capacity bounds the whole cache, not each shard: a shared counter tracks the number of entries and
+     * an insert into a full cache evicts the least recently used entry of its own shard, or of the next
+     * non-empty one when its shard has nothing else to give up.
+     **/
+    class ProgramCache {
+    public:
+        explicit ProgramCache(size_t capacity, size_t shard_count = 16)
+            : capacity(std::max<size_t>(1, capacity))
+            , shards(std::max<size_t>(1, shard_count)) {}
+
+        /** returns the cached outcome or compiles the source and caches it, errors included **/
+        auto get_or_compile(std::string_view source) -> std::expected<std::shared_ptr<const Program>, CompileError> {
+            const auto& [tokens, offsets] = detail::normalize(source);
+
+            auto hash = detail::hash_tokens(tokens);
+            auto index = hash % shards.size();
+            auto& shard = shards[index];
+
+            auto entry = shard.find(hash, tokens);
+            if (entry) {
+                shard.hits.fetch_add(1, std::memory_order_relaxed);
+                detail::record_cache(true);
+            } else {
+                shard.misses.fetch_add(1, std::memory_order_relaxed);
+                detail::record_cache(false);
+
+                // the source is already tokenized, compile it from the tokens instead of lexing it again
+                auto scratch = std::pmr::get_default_resource();
+                detail::ParseScope scope(Grammar::Formula, scratch);
+                auto error_token = no_token;
+                auto program = detail::compile_tokens(source, tokens, offsets, scratch, &error_token);
+                scope.done(program.has_value(), tokens.size());
+
+                auto error = program ? CompileError{} : program.error();
+                if (error_token != no_token) {
+                    // the byte offset only holds for this spelling, the token index for every one
+                    error.offset = error_token;
+                }
+                auto compiled = program ? std::make_shared<const Program>(std::move(*program)) : nullptr;
+                auto [cached, evict_elsewhere] = shard.insert(hash, tokens, Outcome{std::move(compiled), error, error_token != no_token}, size, capacity);
+                if (evict_elsewhere) {
+                    evict_after(index);
+                }
+                entry = std::move(cached);
+            }
+
+            if (!entry->program) {
+                auto at = entry->error.offset;
+                if (entry->at_token) {
+                    at = at < offsets.size() ? offsets[at] : source.size();
+                }
+                return std::unexpected(CompileError{at, entry->error.message});
+            }
+            return entry->program;
+        }
+
+        /** lookup only, nullptr when the source is not cached or failed to compile **/
+        auto find(std::string_view source) const -> std::shared_ptr<const Program> {
+            const auto& tokens = detail::normalize(source).tokens;
+
+            auto hash = detail::hash_tokens(tokens);
+            auto entry = shards[hash % shards.size()].find(hash, tokens);
+            return entry ? entry->program : nullptr;
+        }
+
+        [[nodiscard]] auto stats() const -> CacheStats {
+            CacheStats stats{};
+            for (const auto& shard : shards) {
+                stats.hits += shard.hits.load(std::memory_order_relaxed);
+                stats.misses += shard.misses.load(std::memory_order_relaxed);
+                stats.evictions += shard.evictions.load(std::memory_order_relaxed);
+                stats.size += shard.table.load(std::memory_order_acquire)->size();
+            }
+            return stats;
+        }
+
+    private:
+        /** makes room for an entry inserted into shards[index], which had nothing else to evict **/
+        void evict_after(size_t index) {
+            for (size_t i = 1; i < shards.size(); ++i) {
+                if (shards[(index + i) % shards.size()].evict()) {
+                    size.fetch_sub(1, std::memory_order_relaxed);
+                    return;
+                }
+            }
+        }
+
+        static constexpr size_t no_token = size_t(-1);
+
+        /** a compiled program, or a null program and the error, whose offset is a token index if `at_token` is set **/
+        struct Outcome {
+            std::shared_ptr<const Program> program;
+            CompileError error;
+            bool at_token;
+        };
+
+        struct Entry {
+            std::vector<Token> tokens;
+            std::shared_ptr<const Program> program;
+            CompileError error;
+            bool at_token;
+            mutable std::atomic<uint64_t> last_used;
+        };
+
+        // hashes are kept inline so the binary search does not chase pointers
+        using Table = std::vector<std::pair<uint64_t, std::shared_ptr<const Entry>>>;
+
+        struct alignas(64) Shard {
+            std::atomic<std::shared_ptr<const Table>> table{std::make_shared<const Table>()};
+            std::atomic<uint64_t> epoch{0};
+            std::atomic<uint64_t> hits{0};
+            std::atomic<uint64_t> misses{0};
+            std::atomic<uint64_t> evictions{0};
+            std::mutex write;
+
+            static auto lower_bound(const Table& entries, uint64_t hash) {
+                return std::lower_bound(entries.begin(), entries.end(), hash, [](const auto& entry, uint64_t h) {
+                    return entry.first < h;
+                });
+            }
+
+            auto find(uint64_t hash, std::span<const Token> tokens) const -> std::shared_ptr<const Entry> {
+                auto snapshot = table.load(std::memory_order_acquire);
+                for (auto it = lower_bound(*snapshot, hash); it != snapshot->end() && it->first == hash; ++it) {
+                    const auto& entry = *it->second;
+                    if (detail::same_tokens(entry.tokens, tokens)) {
+                        auto now = epoch.load(std::memory_order_relaxed);
+                        if (entry.last_used.load(std::memory_order_relaxed) != now) {
+                            entry.last_used.store(now, std::memory_order_relaxed);
+                        }
+                        return it->second;
+                    }
+                }
+                return nullptr;
+            }
+
+            static void erase_oldest(Table& entries) {
+                auto victim = std::min_element(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+                    return a.second->last_used.load(std::memory_order_relaxed) < b.second->last_used.load(std::memory_order_relaxed);
+                });
+                entries.erase(victim);
+            }
+
+            /**
+             * inserts the outcome unless another thread cached the same source meanwhile, `size` counts the entries
+             * of every shard; the second result is set when the cache is over capacity and this shard was empty
+             **/
+            auto insert(uint64_t hash, std::span<const Token> tokens, Outcome outcome, std::atomic<size_t>& size, size_t capacity) -> std::pair<std::shared_ptr<const Entry>, bool> {
+                std::lock_guard lock(write);
+
+                if (auto existing = find(hash, tokens)) {
+                    return {existing, false};
+                }
+
+                auto now = epoch.fetch_add(1, std::memory_order_relaxed) + 1;
+                auto snapshot = table.load(std::memory_order_acquire);
+                auto entries = std::make_shared<Table>(*snapshot);
+
+                auto full = size.fetch_add(1, std::memory_order_relaxed) >= capacity;
+                if (full && !entries->empty()) {
+                    erase_oldest(*entries);
+                    evictions.fetch_add(1, std::memory_order_relaxed);
+                    size.fetch_sub(1, std::memory_order_relaxed);
+                    full = false;
+                }
+
+                auto entry = std::make_shared<const Entry>(std::vector<Token>(tokens.begin(), tokens.end()), std::move(outcome.program), outcome.error, outcome.at_token, now);
+                entries->emplace(lower_bound(*entries, hash), hash, entry);
+                table.store(std::move(entries), std::memory_order_release);
+                return {std::move(entry), full};
+            }
+
+            /** drops the least recently used entry, false if the shard is empty **/
+            auto evict() -> bool {
+                std::lock_guard lock(write);
+
+                auto snapshot = table.load(std::memory_order_acquire);
+                if (snapshot->empty()) {
+                    return false;
+                }
+                auto entries = std::make_shared<Table>(*snapshot);
+                erase_oldest(*entries);
+                evictions.fetch_add(1, std::memory_order_relaxed);
+                table.store(std::move(entries), std::memory_order_release);
+                return true;
+            }
+        };
+
+        size_t capacity;
+        std::atomic<size_t> size{0};
+        std::vector<Shard> shards;
+    };
+}
@@ -0,0 +1,403 @@
+//
+// Created by Maksym Pasichnyk on 19.10.2026.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <expected>
+#include <memory_resource>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+
+#include "lexer.hpp"
+#include "program.hpp"
+
+namespace meta::runtime {
+    struct CompileError {
+        size_t offset;
+        std::string_view message;
+    };
+
+    using CompileResult = std::expected<Program, CompileError>;
+
+    /** tokenizes the whole input exactly like SourceStream, offsets[i] is the byte offset of tokens[i] **/
+    inline void tokenize(std::string_view s, std::pmr::vector<Token>& tokens, std::pmr::vector<size_t>& offsets) {
+        scan_tokens(s, [&](Token tk, size_t offset) {
+            tokens.emplace_back(tk);
+            offsets.emplace_back(offset);
+        });
+    }
+
+    namespace detail {
+        static constexpr uint32_t no_node = UINT32_MAX;
+        static constexpr size_t max_nesting = 4096;
+
+        struct Node {
+            OpCode op;
+            uint32_t arg = 0;
+            uint32_t lhs = no_node;
+            uint32_t rhs = no_node;
+            uint32_t need = 1;
+        };
+
+        /**
+         * Runtime mirror of the Function / Expression grammars from expression.hpp:
+         *
+         *  function   := '(' ident* ')' '->' comparison
+         *  comparison := '(' addition cmp addition ')' | addition
+         *  addition   := multiplication ('+' | '-') addition | multiplication
+         *  multiplication := unary ('*' | '/') multiplication | unary
+         *  unary      := ('+' | '-' | '!' | '~') unary | primitive
+         *  primitive  := ident | number | '(' comparison ')'
+         *
+         * Alternatives are ordered exactly like the one_of<> combinators, so the runtime
+         * accepts the same inputs (including right associativity) and computes the same values.
+         * Infix rules are left-factored and comparison is memoized, which keeps backtracking linear.
+         **/
+        struct Parser {
+            std::string_view source;
+            std::span<const Token> tokens;
+            std::span<const size_t> offsets;
+
+            std::pmr::vector<std::string_view> params;
+            std::pmr::vector<Node> nodes;
+            size_t pos = 0;
+            size_t furthest = 0;
+            size_t nesting = 0;
+            std::string_view semantic_error{};
+            size_t semantic_error_pos = 0;
+
+            struct Memo {
+                bool known = false;
+                uint32_t node = no_node;
+                size_t end = 0;
+            };
+            std::pmr::vector<Memo> comparisons;
+
+            [[nodiscard]] auto peek() const -> Token {
+                return pos < tokens.size() ? tokens[pos] : Token{TokenType::End};
+            }
+
+            [[nodiscard]] auto offset_of(size_t where) const -> size_t {
+                return where < offsets.size() ? offsets[where] : source.size();
+            }
+
+            void fail() {
+                furthest = std::max(furthest, pos);
+            }
+
+            auto expect(TokenType type) -> bool {
+                if (peek().is(type)) {
+                    pos += 1;
+                    return true;
+                }
+                fail();
+                return false;
+            }
+
+            /** the stack depth is numbered as the tree is built, commutative operands are ordered so the deeper one is emitted first **/
+            auto make(OpCode op, uint32_t arg, uint32_t lhs = no_node, uint32_t rhs = no_node) -> uint32_t {
+                uint32_t need = 1;
+                if (rhs != no_node) {
+                    if ((op == OpCode::Add || op == OpCode::Mul) && nodes[rhs].need > nodes[lhs].need) {
+                        std::swap(lhs, rhs);
+                    }
+                    need = std::max(nodes[lhs].need, nodes[rhs].need + 1);
+                } else if (lhs != no_node) {
+                    need = nodes[lhs].need;
+                }
+                nodes.emplace_back(Node{op, arg, lhs, rhs, need});
+                return static_cast<uint32_t>(nodes.size() - 1);
+            }
+
+            auto enter() -> bool {
+                if (nesting >= max_nesting) {
+                    if (semantic_error.empty()) {
+                        semantic_error = "expression is too deep";
+                        semantic_error_pos = pos;
+                    }
+                    return false;
+                }
+                nesting += 1;
+                return true;
+            }
+
+            auto parse_function() -> uint32_t {
+                if (!expect(TokenType::LeftParen)) {
+                    return no_node;
+                }
+                while (peek().is(TokenType::Identifier)) {
+                    auto from = offset_of(pos);
+                    auto to = from;
+                    while (to < source.size() && SourceStream::is_identifier_char(source[to])) {
+                        to++;
+                    }
+                    params.emplace_back(source.substr(from, to - from));
+                    pos += 1;
+                }
+                if (!expect(TokenType::RightParen) || !expect(TokenType::Arrow)) {
+                    return no_node;
+                }
+                auto body = parse_comparison();
+                if (body == no_node || !peek().is_end()) {
+                    fail();
+                    return no_node;
+                }
+                return body;
+            }
+
+            auto parse_comparison() -> uint32_t {
+                auto start = pos;
+                if (comparisons[start].known) {
+                    pos = comparisons[start].end;
+                    return comparisons[start].node;
+                }
+                if (!enter()) {
+                    return no_node;
+                }
+                auto node = no_node;
+                if (peek().is(TokenType::LeftParen)) {
+                    pos += 1;
+                    auto lhs = parse_addition();
+                    if (lhs != no_node) {
+                        auto op = comparison_op(peek().type);
+                        if (op) {
+                            pos += 1;
+                            auto rhs = parse_addition();
+                            if (rhs != no_node && expect(TokenType::RightParen)) {
+                                node = make(*op, 0, lhs, rhs);
+                            }
+                        } else {
+                            fail();
+                        }
+                    }
+                }
+                if (node == no_node) {
+                    pos = start;
+                    node = parse_addition();
+                }
+                nesting -= 1;
+                comparisons[start] = Memo{true, node, node == no_node ? start : pos};
+                if (node == no_node) {
+                    pos = start;
+                }
+                return node;
+            }
+
+            auto parse_addition() -> uint32_t {
+                if (!enter()) {
+                    return no_node;
+                }
+                auto lhs = parse_multiplication();
+                if (lhs != no_node && (peek().is(TokenType::Plus) || peek().is(TokenType::Minus))) {
+                    auto save = pos;
+                    auto op = peek().is(TokenType::Plus) ? OpCode::Add : OpCode::Sub;
+                    pos += 1;
+                    auto rhs = parse_addition();
+                    if (rhs != no_node) {
+                        lhs = make(op, 0, lhs, rhs);
+                    } else {
+                        pos = save;
+                    }
+                }
+                nesting -= 1;
+                return lhs;
+            }
+
+            auto parse_multiplication() -> uint32_t {
+                if (!enter()) {
+                    return no_node;
+                }
+                auto lhs = parse_unary();
+                if (lhs != no_node && (peek().is(TokenType::Asterisk) || peek().is(TokenType::Slash))) {
+                    auto save = pos;
+                    auto op = peek().is(TokenType::Asterisk) ? OpCode::Mul : OpCode::Div;
+                    pos += 1;
+                    auto rhs = parse_multiplication();
+                    if (rhs != no_node) {
+                        lhs = make(op, 0, lhs, rhs);
+                    } else {
+                        pos = save;
+                    }
+                }
+                nesting -= 1;
+                return lhs;
+            }
+
+            auto parse_unary() -> uint32_t {
+                auto start = pos;
+                auto type = peek().type;
+                if (type != TokenType::Plus && type != TokenType::Minus && type != TokenType::Not && type != TokenType::Tilde) {
+                    return parse_primitive();
+                }
+                if (!enter()) {
+                    return no_node;
+                }
+                pos += 1;
+                auto arg = parse_unary();
+                nesting -= 1;
+                if (arg == no_node) {
+                    pos = start;
+                    return no_node;
+                }
+                switch (type) {
+                    case TokenType::Minus:
+                        return make(OpCode::Neg, 0, arg);
+                    case TokenType::Not:
+                        return make(OpCode::Not, 0, arg);
+                    case TokenType::Tilde:
+                        return make(OpCode::BitNot, 0, arg);
+                    default:
+                        return arg;
+                }
+            }
+
+            auto parse_primitive() -> uint32_t {
+                auto start = pos;
+                auto tk = peek();
+                if (tk.is(TokenType::Identifier)) {
+                    // parameters are tokens[1..params.size()], their ids are already fnv1a hashes
+                    for (size_t i = 0; i < params.size(); ++i) {
+                        if (tokens[1 + i].id == tk.id) {
+                            pos += 1;
+                            return make(OpCode::Load, static_cast<uint32_t>(i));
+                        }
+                    }
+                    if (semantic_error.empty()) {
+                        semantic_error = "unknown parameter";
+                        semantic_error_pos = pos;
+                    }
+                    return no_node;
+                }
+                if (tk.is(TokenType::Number)) {
+                    pos += 1;
+                    return make(OpCode::Const, static_cast<uint32_t>(tk.id));
+                }
+                if (tk.is(TokenType::LeftParen)) {
+                    pos += 1;
+                    auto node = parse_comparison();
+                    if (node != no_node && expect(TokenType::RightParen)) {
+                        return node;
+                    }
+                    pos = start;
+                    return no_node;
+                }
+                fail();
+                return no_node;
+            }
+
+            static auto comparison_op(TokenType type) -> std::optional<OpCode> {
+                switch (type) {
+                    case TokenType::LessThan:
+                        return OpCode::Less;
+                    case TokenType::LessEqual:
+                        return OpCode::LessEqual;
+                    case TokenType::GreaterThan:
+                        return OpCode::Greater;
+                    case TokenType::GreaterEqual:
+                        return OpCode::GreaterEqual;
+                    default:
+                        return std::nullopt;
+                }
+            }
+        };
+
+        /** post-order code generation, operands were already ordered by Parser::make **/
+        struct Emitter {
+            const std::pmr::vector<Node>& nodes;
+            Program& program;
+            std::pmr::unordered_map<uint32_t, uint32_t> pool;
+
+            void emit(uint32_t index) {
+                const auto& node = nodes[index];
+                if (node.lhs != no_node) {
+                    emit(node.lhs);
+                }
+                if (node.rhs != no_node) {
+                    emit(node.rhs);
+                }
+                if (node.op == OpCode::Const) {
+                    auto [it, inserted] = pool.try_emplace(node.arg, static_cast<uint32_t>(program.constants.size()));
+                    if (inserted) {
+                        program.constants.emplace_back(static_cast<Value>(node.arg));
+                    }
+                    program.code.emplace_back(Instruction{.op = OpCode::Const, .arg = it->second});
+                } else {
+                    program.code.emplace_back(Instruction{.op = node.op, .arg = node.arg});
+                }
+            }
+        };
+
+        /**
+         * turns the parser's outcome into the compile result, generating code for `root` if parsing succeeded;
+         * errors found at a token also store its index in `error_token`, if given
+         **/
+        inline auto finish(Parser& parser, uint32_t root, std::pmr::memory_resource* scratch, size_t* error_token = nullptr) -> CompileResult {
+            if (!parser.semantic_error.empty()) {
+                if (error_token != nullptr) {
+                    *error_token = parser.semantic_error_pos;
+                }
+                return std::unexpected(CompileError{parser.offset_of(parser.semantic_error_pos), parser.semantic_error});
+            }
+            if (root == no_node) {
+                if (error_token != nullptr) {
+                    *error_token = parser.furthest;
+                }
+                auto message = parser.furthest < parser.tokens.size() ? "unexpected token" : "unexpected end of input";
+                return std::unexpected(CompileError{parser.offset_of(parser.furthest), message});
+            }
+
+            Program program{};
+            program.params.assign(parser.params.begin(), parser.params.end());
+
+            Emitter emitter{parser.nodes, program, std::pmr::unordered_map<uint32_t, uint32_t>(scratch)};
+            auto need = parser.nodes[root].need;
+            if (need > max_stack_size) {
+                return std::unexpected(CompileError{0, "expression is too deep"});
+            }
+            program.stack_size = need;
+            emitter.emit(root);
+            return program;
+        }
+    }
+
+    namespace detail {
+        inline auto compile_tokens(std::string_view source, std::span<const Token> tokens, std::span<const size_t> offsets, std::pmr::memory_resource* scratch, size_t* error_token = nullptr) -> CompileResult {
+            Parser parser{
+                .source = source,
+                .tokens = tokens,
+                .offsets = offsets,
+                .params = std::pmr::vector<std::string_view>(scratch),
+                .nodes = std::pmr::vector<Node>(scratch),
+                .comparisons = std::pmr::vector<Parser::Memo>(tokens.size() + 1, scratch),
+            };
+            parser.nodes.reserve(tokens.size());
+
+            return finish(parser, parser.parse_function(), scratch, error_token);
+        }
+    }
+
+    /** compiles already tokenized source, offsets[i] is the offset of tokens[i] within `source` **/
+    inline auto compile_tokens(std::string_view source, std::span<const Token> tokens, std::span<const size_t> offsets, std::pmr::memory_resource* scratch = std::pmr::get_default_resource()) -> CompileResult {
+        detail::ParseScope scope(Grammar::Formula, scratch);
+        auto result = detail::compile_tokens(source, tokens, offsets, scratch);
+        scope.done(result.has_value(), tokens.size());
+        return result;
+    }
+
+    /**
+     * compiles `(params...) -> expr`, the same syntax $fn accepts, into a stack program,
+     * all temporary parser state is allocated from `scratch`
+     **/
+    inline auto compile(std::string_view source, std::pmr::memory_resource* scratch = std::pmr::get_default_resource()) -> CompileResult {
+        detail::ParseScope scope(Grammar::Formula, scratch);
+        std::pmr::vector<Token> tokens(scratch);
+        std::pmr::vector<size_t> offsets(scratch);
+        tokenize(source, tokens, offsets);
+        auto result = detail::compile_tokens(source, tokens, offsets, scratch);
+        scope.done(result.has_value(), tokens.size());
+        return result;
+    }
+}
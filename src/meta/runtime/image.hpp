@@ -0,0 +1,414 @@
+//
+// Created by Maksym Pasichnyk on 19.10.2026.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstring>
+#include <numeric>
+#include <optional>
+
+#include "mapped_file.hpp"
+#include "program.hpp"
+
+namespace meta::runtime {
+    struct ImageError {
+        // set when the file itself could not be read or written
+        std::error_code code;
+        std::string_view message;
+    };
+
+    struct NamedProgram {
+        std::string_view name;
+        const Program& program;
+    };
+
+    namespace detail {
+        static constexpr uint32_t image_magic = 0x4752504D; // "MPRG" when read on a little-endian machine
+        static constexpr uint32_t image_version = 2;
+
+        struct ImageSection {
+            uint64_t offset;
+            uint64_t count;
+        };
+
+        /**
+         * Every offset is relative to the start of the image and every section is 8-byte aligned,
+         * so the image can be mapped anywhere and used in place.
+         **/
+        struct ImageHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t size;
+            uint64_t checksum;          // of the whole image, with this field zeroed
+            uint32_t count;             // programs
+            uint32_t reserved;
+            ImageSection entries;       // ImageEntry, sorted by name
+            ImageSection params;        // ImageString, parameter names of every program
+            ImageSection code;          // Instruction
+            ImageSection constants;     // Value
+            ImageSection strings;       // bytes of every name
+        };
+
+        struct ImageString {
+            uint32_t offset;
+            uint32_t size;
+        };
+
+        /** one program, every field indexes into its section of the image **/
+        struct ImageEntry {
+            ImageString name;
+            uint32_t params;
+            uint32_t arity;
+            uint32_t code;
+            uint32_t code_size;
+            uint32_t constants;
+            uint32_t constants_size;
+            uint32_t stack_size;
+            uint32_t reserved;
+        };
+
+        static_assert(sizeof(ImageHeader) == 112);
+        static_assert(sizeof(ImageEntry) == 40);
+
+        constexpr auto align_image(uint64_t offset) -> uint64_t {
+            return (offset + 7) & ~uint64_t(7);
+        }
+
+        /** word-at-a-time hash, catches truncated and corrupted images, not tampering **/
+        inline auto image_checksum(const ImageHeader& header, std::span<const std::byte> body) -> uint64_t {
+            uint64_t hash = 0x9E3779B97F4A7C15ull ^ (sizeof(header) + body.size());
+            auto mix = [&](uint64_t word) {
+                hash = std::rotl(hash ^ (word * 0x9E3779B97F4A7C15ull), 31) * 0xBF58476D1CE4E5B9ull;
+            };
+
+            // the header is covered too, otherwise a lowered count or a moved section would go unnoticed
+            auto copy = header;
+            copy.checksum = 0;
+            std::byte head[sizeof(copy)];
+            std::memcpy(head, &copy, sizeof(copy));
+            for (size_t i = 0; i < sizeof(head); i += 8) {
+                uint64_t word;
+                std::memcpy(&word, head + i, 8);
+                mix(word);
+            }
+
+            size_t i = 0;
+            for (; i + 8 <= body.size(); i += 8) {
+                uint64_t word;
+                std::memcpy(&word, body.data() + i, 8);
+                mix(word);
+            }
+            uint64_t tail = 0;
+            std::memcpy(&tail, body.data() + i, body.size() - i);
+            mix(tail);
+            hash ^= hash >> 31;
+            return hash;
+        }
+
+        /** true if `count` elements of `size` bytes at `offset` lie inside an image of `total` bytes **/
+        constexpr auto fits(uint64_t offset, uint64_t count, uint64_t size, uint64_t total) -> bool {
+            return offset <= total && count <= (total - offset) / size;
+        }
+
+        /**
+         * true if evaluating `program` stays inside its arguments, constants and `stack_size` slots:
+         * every opcode is known, every operand is in range and the code leaves exactly one value
+         **/
+        inline auto verify_code(const ProgramView& program) -> bool {
+            size_t depth = 0;
+            for (const auto& instruction : program.code) {
+                switch (instruction.op) {
+                    case OpCode::Load:
+                        if (instruction.arg >= program.arity) {
+                            return false;
+                        }
+                        depth += 1;
+                        break;
+                    case OpCode::Const:
+                        if (instruction.arg >= program.constants.size()) {
+                            return false;
+                        }
+                        depth += 1;
+                        break;
+                    case OpCode::Neg:
+                    case OpCode::Not:
+                    case OpCode::BitNot:
+                        if (depth < 1) {
+                            return false;
+                        }
+                        break;
+                    case OpCode::Add:
+                    case OpCode::Sub:
+                    case OpCode::Mul:
+                    case OpCode::Div:
+                    case OpCode::Less:
+                    case OpCode::LessEqual:
+                    case OpCode::Greater:
+                    case OpCode::GreaterEqual:
+                        if (depth < 2) {
+                            return false;
+                        }
+                        depth -= 1;
+                        break;
+                    default:
+                        return false;
+                }
+                if (depth > program.stack_size) {
+                    return false;
+                }
+            }
+            return depth == 1;
+        }
+    }
+
+    /** serializes `programs` into an image, names must be unique **/
+    inline auto build_image(std::span<const NamedProgram> programs) -> std::vector<std::byte> {
+        std::vector<size_t> order(programs.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](auto lhs, auto rhs) {
+            return programs[lhs].name < programs[rhs].name;
+        });
+
+        detail::ImageHeader header{};
+        header.magic = detail::image_magic;
+        header.version = detail::image_version;
+        header.count = static_cast<uint32_t>(programs.size());
+        for (const auto& [name, program] : programs) {
+            header.params.count += program.params.size();
+            header.code.count += program.code.size();
+            header.constants.count += program.constants.size();
+            header.strings.count += name.size();
+            for (const auto& param : program.params) {
+                header.strings.count += param.size();
+            }
+        }
+        header.entries = {detail::align_image(sizeof(header)), programs.size()};
+        header.params.offset = detail::align_image(header.entries.offset + header.entries.count * sizeof(detail::ImageEntry));
+        header.code.offset = detail::align_image(header.params.offset + header.params.count * sizeof(detail::ImageString));
+        header.constants.offset = detail::align_image(header.code.offset + header.code.count * sizeof(Instruction));
+        header.strings.offset = detail::align_image(header.constants.offset + header.constants.count * sizeof(Value));
+        header.size = detail::align_image(header.strings.offset + header.strings.count);
+
+        std::vector<std::byte> image(header.size);
+        auto* base = image.data();
+        uint32_t params = 0;
+        uint32_t code = 0;
+        uint32_t constants = 0;
+        uint32_t strings = 0;
+
+        auto add_string = [&](std::string_view s) {
+            std::memcpy(base + header.strings.offset + strings, s.data(), s.size());
+            auto ref = detail::ImageString{strings, static_cast<uint32_t>(s.size())};
+            strings += static_cast<uint32_t>(s.size());
+            return ref;
+        };
+
+        for (size_t i = 0; i < order.size(); ++i) {
+            const auto& [name, program] = programs[order[i]];
+            assert(i == 0 || programs[order[i - 1]].name != name);
+
+            detail::ImageEntry entry{};
+            entry.name = add_string(name);
+            entry.params = params;
+            entry.arity = static_cast<uint32_t>(program.params.size());
+            entry.code = code;
+            entry.code_size = static_cast<uint32_t>(program.code.size());
+            entry.constants = constants;
+            entry.constants_size = static_cast<uint32_t>(program.constants.size());
+            entry.stack_size = program.stack_size;
+            std::memcpy(base + header.entries.offset + i * sizeof(entry), &entry, sizeof(entry));
+
+            for (const auto& param : program.params) {
+                auto ref = add_string(param);
+                std::memcpy(base + header.params.offset + params * sizeof(ref), &ref, sizeof(ref));
+                params += 1;
+            }
+            std::memcpy(base + header.code.offset + code * sizeof(Instruction), program.code.data(), program.code.size() * sizeof(Instruction));
+            code += entry.code_size;
+            std::memcpy(base + header.constants.offset + constants * sizeof(Value), program.constants.data(), program.constants.size() * sizeof(Value));
+            constants += entry.constants_size;
+        }
+
+        header.checksum = detail::image_checksum(header, std::span(image).subspan(sizeof(header)));
+        std::memcpy(base, &header, sizeof(header));
+        return image;
+    }
+
+    inline auto save_image(const char* path, std::span<const NamedProgram> programs) -> std::expected<void, ImageError> {
+        auto image = build_image(programs);
+        auto fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            return std::unexpected(ImageError{std::error_code(errno, std::system_category()), "cannot create image"});
+        }
+        for (size_t written = 0; written < image.size();) {
+            auto n = ::write(fd, image.data() + written, image.size() - written);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                auto error = std::error_code(errno, std::system_category());
+                ::close(fd);
+                return std::unexpected(ImageError{error, "cannot write image"});
+            }
+            written += static_cast<size_t>(n);
+        }
+        if (::close(fd) != 0) {
+            return std::unexpected(ImageError{std::error_code(errno, std::system_category()), "cannot write image"});
+        }
+        return {};
+    }
+
+    /** a program inside a ProgramImage, valid while the image is **/
+    struct ImageProgram {
+        std::string_view name;
+        ProgramView program;
+        std::span<const detail::ImageString> params;
+        const char* strings = nullptr;
+
+        [[nodiscard]] auto param(size_t index) const -> std::string_view {
+            return {strings + params[index].offset, params[index].size};
+        }
+
+        auto operator()(std::span<const Value> args) const -> Value {
+            return evaluate(program, args);
+        }
+    };
+
+    /**
+     * Read-only view of an image written by save_image. Opening maps the file once and checks the header,
+     * the bounds and order of every entry, the bytecode of every program and (unless disabled) the checksum
+     * over the header and the body;
+     * programs are then used in place, nothing is copied or allocated.
+     **/
+    class ProgramImage {
+    public:
+        static auto open(const char* path, bool verify_checksum = true) -> std::expected<ProgramImage, ImageError> {
+            auto file = MappedFile::open(path);
+            if (!file) {
+                return std::unexpected(ImageError{file.error(), "cannot map image"});
+            }
+            auto bytes = std::as_bytes(std::span(file->view()));
+            auto image = load(bytes, verify_checksum);
+            if (image) {
+                // moving the mapping does not move the pages, the views stay valid
+                image->file = std::move(*file);
+            }
+            return image;
+        }
+
+        /** uses an image already in memory, `bytes` must be 8-byte aligned and outlive the result **/
+        static auto load(std::span<const std::byte> bytes, bool verify_checksum = true) -> std::expected<ProgramImage, ImageError> {
+            auto error = [](std::string_view message) {
+                return std::unexpected(ImageError{{}, message});
+            };
+
+            detail::ImageHeader header;
+            if (bytes.size() < sizeof(header)) {
+                return error("truncated image");
+            }
+            std::memcpy(&header, bytes.data(), sizeof(header));
+            if (header.magic != detail::image_magic) {
+                return error("not a program image");
+            }
+            if (header.version != detail::image_version) {
+                return error("unsupported image version");
+            }
+            if (header.size != bytes.size()) {
+                return error("truncated image");
+            }
+            if (reinterpret_cast<uintptr_t>(bytes.data()) % 8 != 0) {
+                return error("misaligned image");
+            }
+
+            auto section = [&](const detail::ImageSection& s, size_t size) {
+                return s.offset % 8 == 0 && detail::fits(s.offset, s.count, size, header.size);
+            };
+            if (!section(header.entries, sizeof(detail::ImageEntry)) || header.entries.count != header.count
+                || !section(header.params, sizeof(detail::ImageString)) || !section(header.code, sizeof(Instruction))
+                || !section(header.constants, sizeof(Value)) || !section(header.strings, 1)) {
+                return error("corrupted image");
+            }
+            if (verify_checksum && detail::image_checksum(header, bytes.subspan(sizeof(header))) != header.checksum) {
+                return error("checksum mismatch");
+            }
+
+            ProgramImage image;
+            image.base = bytes.data();
+            image.entries = {reinterpret_cast<const detail::ImageEntry*>(image.base + header.entries.offset), header.entries.count};
+            image.params = {reinterpret_cast<const detail::ImageString*>(image.base + header.params.offset), header.params.count};
+            image.code = {reinterpret_cast<const Instruction*>(image.base + header.code.offset), header.code.count};
+            image.constants = {reinterpret_cast<const Value*>(image.base + header.constants.offset), header.constants.count};
+            image.strings = {reinterpret_cast<const char*>(image.base + header.strings.offset), header.strings.count};
+
+            // evaluate() trusts its program, so every range it will read and every instruction it will run is checked once here
+            auto string_fits = [&](const detail::ImageString& s) {
+                return detail::fits(s.offset, s.size, 1, image.strings.size());
+            };
+            for (const auto& entry : image.entries) {
+                if (!string_fits(entry.name) || !detail::fits(entry.params, entry.arity, 1, image.params.size())
+                    || !detail::fits(entry.code, entry.code_size, 1, image.code.size())
+                    || !detail::fits(entry.constants, entry.constants_size, 1, image.constants.size())
+                    || entry.stack_size > max_stack_size) {
+                    return error("corrupted image");
+                }
+                auto program = ProgramView{image.code.subspan(entry.code, entry.code_size), image.constants.subspan(entry.constants, entry.constants_size), entry.arity, entry.stack_size};
+                if (!detail::verify_code(program)) {
+                    return error("corrupted image");
+                }
+            }
+            if (!std::all_of(image.params.begin(), image.params.end(), string_fits)) {
+                return error("corrupted image");
+            }
+            // find() is a binary search, names have to be strictly ascending
+            auto out_of_order = std::adjacent_find(image.entries.begin(), image.entries.end(), [&](const auto& lhs, const auto& rhs) {
+                return !(image.name_of(lhs) < image.name_of(rhs));
+            });
+            if (out_of_order != image.entries.end()) {
+                return error("corrupted image");
+            }
+            return image;
+        }
+
+        [[nodiscard]] auto size() const -> size_t {
+            return entries.size();
+        }
+
+        [[nodiscard]] auto operator[](size_t index) const -> ImageProgram {
+            const auto& entry = entries[index];
+            return ImageProgram{
+                name_of(entry),
+                ProgramView{code.subspan(entry.code, entry.code_size), constants.subspan(entry.constants, entry.constants_size), entry.arity, entry.stack_size},
+                params.subspan(entry.params, entry.arity),
+                strings.data()
+            };
+        }
+
+        /** binary search over the names, entries are stored sorted **/
+        [[nodiscard]] auto find(std::string_view name) const -> std::optional<ImageProgram> {
+            auto it = std::lower_bound(entries.begin(), entries.end(), name, [&](const detail::ImageEntry& entry, std::string_view key) {
+                return name_of(entry) < key;
+            });
+            if (it == entries.end() || name_of(*it) != name) {
+                return std::nullopt;
+            }
+            return (*this)[static_cast<size_t>(it - entries.begin())];
+        }
+
+    private:
+        [[nodiscard]] auto name_of(const detail::ImageEntry& entry) const -> std::string_view {
+            return strings.substr(entry.name.offset, entry.name.size);
+        }
+
+        MappedFile file;
+        const std::byte* base = nullptr;
+        std::span<const detail::ImageEntry> entries;
+        std::span<const detail::ImageString> params;
+        std::span<const Instruction> code;
+        std::span<const Value> constants;
+        std::string_view strings;
+    };
+}
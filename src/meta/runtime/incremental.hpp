@@ -0,0 +1,468 @@
+//
+// Created by Maksym Pasichnyk on 19.10.2026.
+//
+
+#pragma once
+
+#include <cassert>
+#include <coroutine>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <utility>
+
+#include "compiler.hpp"
+
+namespace meta::runtime {
+    namespace detail {
+        /**
+         * Lazily started coroutine returning a node index. Awaiting it runs the rule, and when the rule finishes
+         * control transfers straight back to the awaiting rule, so suspending and resuming a deep parse costs no
+         * native stack. Frames come from the owning parser's `frames` resource. An exception thrown inside a rule
+         * is stored and rethrown in the awaiting rule, so it travels up to whoever resumed the root.
+         **/
+        struct ParseTask {
+            struct promise_type {
+                static constexpr size_t header = alignof(std::max_align_t);
+
+                uint32_t node = no_node;
+                std::coroutine_handle<> continuation = std::noop_coroutine();
+                std::exception_ptr error;
+
+                template<typename Owner>
+                static auto operator new(size_t size, Owner& owner) -> void* {
+                    auto* resource = owner.frames;
+                    auto* ptr = static_cast<std::byte*>(resource->allocate(size + header, alignof(std::max_align_t)));
+                    std::memcpy(ptr, &resource, sizeof(resource));
+                    return ptr + header;
+                }
+
+                static void operator delete(void* frame, size_t size) {
+                    auto* ptr = static_cast<std::byte*>(frame) - header;
+                    std::pmr::memory_resource* resource;
+                    std::memcpy(&resource, ptr, sizeof(resource));
+                    resource->deallocate(ptr, size + header, alignof(std::max_align_t));
+                }
+
+                auto get_return_object() -> ParseTask {
+                    return ParseTask{std::coroutine_handle<promise_type>::from_promise(*this)};
+                }
+
+                auto initial_suspend() noexcept -> std::suspend_always {
+                    return {};
+                }
+
+                auto final_suspend() noexcept {
+                    struct Transfer {
+                        auto await_ready() noexcept -> bool {
+                            return false;
+                        }
+
+                        auto await_suspend(std::coroutine_handle<promise_type> self) noexcept -> std::coroutine_handle<> {
+                            return self.promise().continuation;
+                        }
+
+                        void await_resume() noexcept {}
+                    };
+                    return Transfer{};
+                }
+
+                void return_value(uint32_t value) {
+                    node = value;
+                }
+
+                void unhandled_exception() {
+                    error = std::current_exception();
+                }
+            };
+
+            ParseTask() = default;
+
+            explicit ParseTask(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+            ParseTask(ParseTask&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+
+            auto operator=(ParseTask&& other) noexcept -> ParseTask& {
+                if (this != &other) {
+                    reset();
+                    handle = std::exchange(other.handle, nullptr);
+                }
+                return *this;
+            }
+
+            ~ParseTask() {
+                reset();
+            }
+
+            auto await_ready() noexcept -> bool {
+                return false;
+            }
+
+            auto await_suspend(std::coroutine_handle<> caller) noexcept -> std::coroutine_handle<> {
+                handle.promise().continuation = caller;
+                return handle;
+            }
+
+            auto await_resume() -> uint32_t {
+                if (handle.promise().error) {
+                    std::rethrow_exception(handle.promise().error);
+                }
+                return handle.promise().node;
+            }
+
+            void reset() {
+                // destroying a suspended rule also destroys the rule it is awaiting
+                if (handle) {
+                    handle.destroy();
+                }
+                handle = nullptr;
+            }
+
+            std::coroutine_handle<promise_type> handle{};
+        };
+
+        /**
+         * Parser with every rule turned into a coroutine. Before looking at a token the rule awaits it, and if the
+         * token has not arrived yet the whole chain of rules is suspended in place, with the partially parsed
+         * groups and lists kept in the suspended frames. Rules and alternatives are the same as in Parser,
+         * so for the same input both produce the same nodes and the same errors.
+         **/
+        struct AsyncParser : Parser {
+            std::pmr::memory_resource* frames = nullptr;
+            std::coroutine_handle<> waiting{};
+            bool finished = false;
+
+            struct Available {
+                AsyncParser& parser;
+
+                [[nodiscard]] auto await_ready() const noexcept -> bool {
+                    return parser.ready();
+                }
+
+                void await_suspend(std::coroutine_handle<> rule) noexcept {
+                    parser.waiting = rule;
+                }
+
+                void await_resume() const noexcept {}
+            };
+
+            /** the token at `pos` is known, either it has arrived or the input is complete **/
+            [[nodiscard]] auto ready() const -> bool {
+                return pos < tokens.size() || finished;
+            }
+
+            auto available() -> Available {
+                return Available{*this};
+            }
+
+            /** parameter names are only taken once the input is complete, the buffer may move while it grows **/
+            void resolve_params() {
+                for (size_t i = 0; i < params.size(); ++i) {
+                    auto from = offset_of(1 + i);
+                    auto to = from;
+                    while (to < source.size() && SourceStream::is_identifier_char(source[to])) {
+                        to++;
+                    }
+                    params[i] = source.substr(from, to - from);
+                }
+            }
+
+            auto parse_function() -> ParseTask {
+                co_await available();
+                if (!expect(TokenType::LeftParen)) {
+                    co_return no_node;
+                }
+                while (true) {
+                    co_await available();
+                    if (!peek().is(TokenType::Identifier)) {
+                        break;
+                    }
+                    params.emplace_back();
+                    pos += 1;
+                }
+                if (!expect(TokenType::RightParen)) {
+                    co_return no_node;
+                }
+                co_await available();
+                if (!expect(TokenType::Arrow)) {
+                    co_return no_node;
+                }
+                auto body = co_await parse_comparison();
+                // a failed body is already the result, waiting for the next token would only delay the error
+                if (body == no_node) {
+                    fail();
+                    co_return no_node;
+                }
+                co_await available();
+                if (!peek().is_end()) {
+                    fail();
+                    co_return no_node;
+                }
+                co_return body;
+            }
+
+            auto parse_comparison() -> ParseTask {
+                auto start = pos;
+                co_await available();
+                if (comparisons[start].known) {
+                    pos = comparisons[start].end;
+                    co_return comparisons[start].node;
+                }
+                if (!enter()) {
+                    co_return no_node;
+                }
+                auto node = no_node;
+                if (peek().is(TokenType::LeftParen)) {
+                    pos += 1;
+                    auto lhs = co_await parse_addition();
+                    if (lhs != no_node) {
+                        co_await available();
+                        auto op = comparison_op(peek().type);
+                        if (op) {
+                            pos += 1;
+                            auto rhs = co_await parse_addition();
+                            if (rhs != no_node) {
+                                co_await available();
+                                if (expect(TokenType::RightParen)) {
+                                    node = make(*op, 0, lhs, rhs);
+                                }
+                            }
+                        } else {
+                            fail();
+                        }
+                    }
+                }
+                if (node == no_node) {
+                    pos = start;
+                    node = co_await parse_addition();
+                }
+                nesting -= 1;
+                comparisons[start] = Memo{true, node, node == no_node ? start : pos};
+                if (node == no_node) {
+                    pos = start;
+                }
+                co_return node;
+            }
+
+            auto parse_addition() -> ParseTask {
+                if (!enter()) {
+                    co_return no_node;
+                }
+                auto lhs = co_await parse_multiplication();
+                if (lhs != no_node) {
+                    co_await available();
+                    if (peek().is(TokenType::Plus) || peek().is(TokenType::Minus)) {
+                        auto save = pos;
+                        auto op = peek().is(TokenType::Plus) ? OpCode::Add : OpCode::Sub;
+                        pos += 1;
+                        auto rhs = co_await parse_addition();
+                        if (rhs != no_node) {
+                            lhs = make(op, 0, lhs, rhs);
+                        } else {
+                            pos = save;
+                        }
+                    }
+                }
+                nesting -= 1;
+                co_return lhs;
+            }
+
+            auto parse_multiplication() -> ParseTask {
+                if (!enter()) {
+                    co_return no_node;
+                }
+                auto lhs = co_await parse_unary();
+                if (lhs != no_node) {
+                    co_await available();
+                    if (peek().is(TokenType::Asterisk) || peek().is(TokenType::Slash)) {
+                        auto save = pos;
+                        auto op = peek().is(TokenType::Asterisk) ? OpCode::Mul : OpCode::Div;
+                        pos += 1;
+                        auto rhs = co_await parse_multiplication();
+                        if (rhs != no_node) {
+                            lhs = make(op, 0, lhs, rhs);
+                        } else {
+                            pos = save;
+                        }
+                    }
+                }
+                nesting -= 1;
+                co_return lhs;
+            }
+
+            auto parse_unary() -> ParseTask {
+                auto start = pos;
+                co_await available();
+                auto type = peek().type;
+                if (type != TokenType::Plus && type != TokenType::Minus && type != TokenType::Not && type != TokenType::Tilde) {
+                    co_return co_await parse_primitive();
+                }
+                if (!enter()) {
+                    co_return no_node;
+                }
+                pos += 1;
+                auto arg = co_await parse_unary();
+                nesting -= 1;
+                if (arg == no_node) {
+                    pos = start;
+                    co_return no_node;
+                }
+                switch (type) {
+                    case TokenType::Minus:
+                        co_return make(OpCode::Neg, 0, arg);
+                    case TokenType::Not:
+                        co_return make(OpCode::Not, 0, arg);
+                    case TokenType::Tilde:
+                        co_return make(OpCode::BitNot, 0, arg);
+                    default:
+                        co_return arg;
+                }
+            }
+
+            auto parse_primitive() -> ParseTask {
+                auto start = pos;
+                co_await available();
+                auto tk = peek();
+                if (tk.is(TokenType::Identifier)) {
+                    for (size_t i = 0; i < params.size(); ++i) {
+                        if (tokens[1 + i].id == tk.id) {
+                            pos += 1;
+                            co_return make(OpCode::Load, static_cast<uint32_t>(i));
+                        }
+                    }
+                    if (semantic_error.empty()) {
+                        semantic_error = "unknown parameter";
+                        semantic_error_pos = pos;
+                    }
+                    co_return no_node;
+                }
+                if (tk.is(TokenType::Number)) {
+                    pos += 1;
+                    co_return make(OpCode::Const, static_cast<uint32_t>(tk.id));
+                }
+                if (tk.is(TokenType::LeftParen)) {
+                    pos += 1;
+                    auto node = co_await parse_comparison();
+                    if (node != no_node) {
+                        co_await available();
+                        if (expect(TokenType::RightParen)) {
+                            co_return node;
+                        }
+                    }
+                    pos = start;
+                    co_return no_node;
+                }
+                fail();
+                co_return no_node;
+            }
+        };
+    }
+
+    /**
+     * Compiles one `(params...) -> expr` whose text arrives in pieces, e.g. from a socket or a pipe. Every chunk
+     * is tokenized and parsed as soon as it is fed; the parser suspends when it runs out of tokens and resumes
+     * where it stopped when the next chunk comes in. A token cut by the end of a chunk is held back until the
+     * rest of it arrives. Only the tail of the input is left to parse when finish() is called.
+     * Exceptions thrown while parsing, such as std::bad_alloc, leave feed() or finish() and end the compilation:
+     * the compiler must not be used after that.
+     *
+     *  IncrementalCompiler compiler;
+     *  while (read(fd, buffer)) {
+     *      if (compiler.feed(buffer)) break;   // the result is already known, e.g. a syntax error
+     *  }
+     *  auto program = compiler.finish();
+     **/
+    class IncrementalCompiler {
+    public:
+        explicit IncrementalCompiler(Isa isa = best_isa()) : isa(isa) {
+            parser.frames = &frames;
+            root = parser.parse_function();
+            // started by the first resume, once there is a token to look at
+            parser.waiting = root.handle;
+        }
+
+        IncrementalCompiler(const IncrementalCompiler&) = delete;
+        auto operator=(const IncrementalCompiler&) -> IncrementalCompiler& = delete;
+
+        /** appends the next piece of input and parses as far as it goes, true once the result is known **/
+        auto feed(std::string_view chunk) -> bool {
+            assert(!parser.finished);
+            if (result) {
+                return true;
+            }
+            [[maybe_unused]] auto lap = stopwatch.lap();
+            text.append(chunk);
+            lex();
+            resume();
+            return result.has_value();
+        }
+
+        /** marks the end of input and returns the result, may only be called once **/
+        auto finish() -> CompileResult {
+            assert(!parser.finished);
+            parser.finished = true;
+            if (!result) {
+                [[maybe_unused]] auto lap = stopwatch.lap();
+                lex();
+                resume();
+            }
+            assert(result);
+            return std::move(*result);
+        }
+
+        /** bytes received so far **/
+        [[nodiscard]] auto size() const -> size_t {
+            return text.size();
+        }
+
+    private:
+        void lex() {
+            FastSourceStream stream{text, lexed, lexed, isa};
+            while (true) {
+                auto tk = stream.token();
+                if (tk.is_end()) {
+                    lexed = stream.i;
+                    break;
+                }
+                // more bytes could still extend it: `1` into `12`, `-` into `->`
+                if (!parser.finished && stream.i == text.size()) {
+                    lexed = stream.from;
+                    break;
+                }
+                tokens.emplace_back(tk);
+                offsets.emplace_back(stream.from);
+            }
+            parser.source = text;
+            parser.tokens = tokens;
+            parser.offsets = offsets;
+            parser.comparisons.resize(tokens.size() + 1);
+        }
+
+        void resume() {
+            if (parser.waiting && parser.ready()) {
+                std::exchange(parser.waiting, nullptr).resume();
+            }
+            if (root.handle && root.handle.done()) {
+                if (auto error = root.handle.promise().error) {
+                    root.reset();
+                    std::rethrow_exception(error);
+                }
+                parser.resolve_params();
+                result = detail::finish(parser, root.handle.promise().node, &frames);
+                root.reset();
+                stopwatch.done(Grammar::Incremental, result->has_value(), tokens.size());
+            }
+        }
+
+        Isa isa;
+        std::string text;
+        size_t lexed = 0;
+        std::pmr::vector<Token> tokens;
+        std::pmr::vector<size_t> offsets;
+        std::pmr::unsynchronized_pool_resource frames;
+        detail::AsyncParser parser{};
+        detail::ParseTask root;
+        std::optional<CompileResult> result;
+        [[no_unique_address]] detail::ParseStopwatch stopwatch;
+    };
+}
@@ -0,0 +1,55 @@
+//
+// Created by Maksym Pasichnyk on 19.10.2026.
+//
+
+#pragma once
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define META_RUNTIME_X86 1
+#endif
+
+namespace meta::runtime {
+    /** instruction sets the runtime has kernels for, ordered from the narrowest **/
+    enum class Isa {
+        Scalar,
+        Sse2,
+        Sse42,
+        Avx2,
+    };
+
+    /** the widest instruction set the running cpu supports **/
+    inline auto best_isa() -> Isa {
+#if META_RUNTIME_X86
+        static const auto isa = [] {
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) {
+                return Isa::Avx2;
+            }
+            if (__builtin_cpu_supports("sse4.2")) {
+                return Isa::Sse42;
+            }
+            if (__builtin_cpu_supports("sse2")) {
+                return Isa::Sse2;
+            }
+            return Isa::Scalar;
+        }();
+        return isa;
+#else
+        return Isa::Scalar;
+#endif
+    }
+
+    inline auto isa_name(Isa isa) -> const char* {
+        switch (isa) {
+            case Isa::Avx2:
+                return "avx2";
+            case Isa::Sse42:
+                return "sse4.2";
+            case Isa::Sse2:
+                return "sse2";
+            default:
+                return "scalar";
+        }
+    }
+}
@@ -0,0 +1,287 @@
+//
+// Created by Maksym Pasichnyk on 19.10.2026.
+//
+
+#pragma once
+
+#include <bit>
+
+#include "isa.hpp"
+#include "../token_stream.hpp"
+
+namespace meta::runtime {
+    namespace detail {
+        /** reference scanner, the same character classes SourceStream uses **/
+        struct ScalarScanner {
+            static auto skip_space(const char* s, size_t i, size_t n) -> size_t {
+                while (i < n && SourceStream::is_space_char(s[i])) {
+                    i++;
+                }
+                return i;
+            }
+
+            static auto identifier_end(const char* s, size_t i, size_t n) -> size_t {
+                while (i < n && SourceStream::is_identifier_char(s[i])) {
+                    i++;
+                }
+                return i;
+            }
+
+            static auto digits_end(const char* s, size_t i, size_t n) -> size_t {
+                while (i < n && SourceStream::is_digit(s[i])) {
+                    i++;
+                }
+                return i;
+            }
+        };
+
+#if META_RUNTIME_X86
+        /** 16 bytes at a time with pcmpistri, blocks that would cross the end of input go through ScalarScanner **/
+        struct Sse42Scanner {
+            static constexpr int ranges = _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_NEGATIVE_POLARITY | _SIDD_LEAST_SIGNIFICANT;
+            static constexpr int any = _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_NEGATIVE_POLARITY | _SIDD_LEAST_SIGNIFICANT;
+
+            // negative polarity also flips the bytes after an embedded NUL, so scanning stops at it like at any other byte
+
+            template<int mode>
+            __attribute__((target("sse4.2")))
+            static auto scan(const char* s, size_t i, size_t n, __m128i set) -> size_t {
+                for (; i + 16 <= n; i += 16) {
+                    auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+                    auto index = _mm_cmpistri(set, block, mode);
+                    if (index < 16) {
+                        return i + static_cast<size_t>(index);
+                    }
+                }
+                return i;
+            }
+
+            __attribute__((target("sse4.2")))
+            static auto skip_space(const char* s, size_t i, size_t n) -> size_t {
+                i = scan<any>(s, i, n, _mm_setr_epi8(' ', '\t', '\n', '\r', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0));
+                return ScalarScanner::skip_space(s, i, n);
+            }
+
+            __attribute__((target("sse4.2")))
+            static auto identifier_end(const char* s, size_t i, size_t n) -> size_t {
+                i = scan<ranges>(s, i, n, _mm_setr_epi8('a', 'z', 'A', 'Z', '0', '9', '_', '_', 0, 0, 0, 0, 0, 0, 0, 0));
+                return ScalarScanner::identifier_end(s, i, n);
+            }
+
+            __attribute__((target("sse4.2")))
+            static auto digits_end(const char* s, size_t i, size_t n) -> size_t {
+                i = scan<ranges>(s, i, n, _mm_setr_epi8('0', '9', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0));
+                return ScalarScanner::digits_end(s, i, n);
+            }
+        };
+
+        /** 32 bytes at a time, every character class is a movemask over byte compares **/
+        struct Avx2Scanner {
+            __attribute__((target("avx2")))
+            static auto in_range(__m256i c, char lo, char hi) -> __m256i {
+                return _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8(static_cast<char>(lo - 1))), _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(hi + 1)), c));
+            }
+
+            __attribute__((target("avx2")))
+            static auto space_mask(__m256i c) -> uint32_t {
+                auto m = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\t'))),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\r')))
+                );
+                return static_cast<uint32_t>(_mm256_movemask_epi8(m));
+            }
+
+            __attribute__((target("avx2")))
+            static auto digit_mask(__m256i c) -> uint32_t {
+                return static_cast<uint32_t>(_mm256_movemask_epi8(in_range(c, '0', '9')));
+            }
+
+            __attribute__((target("avx2")))
+            static auto identifier_mask(__m256i c) -> uint32_t {
+                // c | 0x20 folds upper case letters onto lower case, and maps no other byte into 'a'..'z'
+                auto letters = in_range(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), 'a', 'z');
+                auto m = _mm256_or_si256(_mm256_or_si256(letters, in_range(c, '0', '9')), _mm256_cmpeq_epi8(c, _mm256_set1_epi8('_')));
+                return static_cast<uint32_t>(_mm256_movemask_epi8(m));
+            }
+
+            /**
+             * Every block is classified once: the space, digit and identifier masks of the 32 bytes at `base`
+             * are kept, so the runs that start and end inside it are found with shifts, without another load.
+             * Blocks are loaded at the position that needs them and may overlap the previous one.
+             **/
+            size_t base = size_t(-64);     // far below any position, so the first scan loads a block
+            uint32_t spaces = 0;
+            uint32_t digits = 0;
+            uint32_t identifiers = 0;
+
+            __attribute__((target("avx2")))
+            void load(const char* s, size_t i) {
+                auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+                base = i;
+                spaces = space_mask(block);
+                digits = digit_mask(block);
+                identifiers = identifier_mask(block);
+            }
+
+            template<uint32_t Avx2Scanner::* mask>
+            __attribute__((target("avx2")))
+            auto scan(const char* s, size_t i, size_t n) -> size_t {
+                while (true) {
+                    if (i - base >= 32) {
+                        if (i + 32 > n) {
+                            return i;
+                        }
+                        load(s, i);
+                    }
+                    // bits past the block shift in as zero, i.e. as bytes that do not stop the run
+                    auto stop = ~(this->*mask) >> (i - base);
+                    if (stop != 0) {
+                        return i + static_cast<size_t>(std::countr_zero(stop));
+                    }
+                    i = base + 32;
+                }
+            }
+
+            __attribute__((target("avx2")))
+            auto skip_space(const char* s, size_t i, size_t n) -> size_t {
+                return ScalarScanner::skip_space(s, scan<&Avx2Scanner::spaces>(s, i, n), n);
+            }
+
+            __attribute__((target("avx2")))
+            auto identifier_end(const char* s, size_t i, size_t n) -> size_t {
+                return ScalarScanner::identifier_end(s, scan<&Avx2Scanner::identifiers>(s, i, n), n);
+            }
+
+            __attribute__((target("avx2")))
+            auto digits_end(const char* s, size_t i, size_t n) -> size_t {
+                return ScalarScanner::digits_end(s, scan<&Avx2Scanner::digits>(s, i, n), n);
+            }
+        };
+#endif
+
+        /**
+         * One token starting at or after `i`, identical to SourceStream::token(). Runs of whitespace, digits and
+         * identifier characters are delimited by the scanner, the run is then folded into the number or hashed
+         * while it is still in L1. Punctuation is delegated to SourceStream itself.
+         *
+         * Avx2Scanner classifies every 32-byte block once and keeps its masks, so the runs of the next tokens in
+         * the block are found without loading it again; pcmpistri returns an index rather than a mask, so
+         * Sse42Scanner still scans per run. Token ids have to be the fnv1a hashes the compile-time lexer produces,
+         * a serial multiply per byte that reads each identifier again after its end is known. That hash bounds
+         * throughput: both vector scanners stay within about 10% of the scalar one.
+         **/
+        template<typename Scanner>
+        [[gnu::always_inline]] inline auto scan_token(Scanner& scanner, std::string_view s, size_t& i, size_t& from) -> Token {
+            // most tokens are separated by a single space, only longer runs are worth a vector scan
+            if (i < s.size() && SourceStream::is_space_char(s[i])) {
+                i += 1;
+                if (i < s.size() && SourceStream::is_space_char(s[i])) {
+                    i = scanner.skip_space(s.data(), i, s.size());
+                }
+            }
+            from = i;
+            if (i >= s.size()) {
+                return Token{TokenType::End};
+            }
+            if (SourceStream::is_digit(s[i])) {
+                auto end = scanner.digits_end(s.data(), i, s.size());
+                size_t number = 0;
+                for (; i < end; ++i) {
+                    number *= 10;
+                    number += s[i] - '0';
+                }
+                return Token{TokenType::Number, number};
+            }
+            if (SourceStream::is_identifier_char(s[i])) {
+                auto end = scanner.identifier_end(s.data(), i, s.size());
+                auto hash = fnv1a(s.substr(i, end - i));
+                i = end;
+                return Token{TokenType::Identifier, hash};
+            }
+            SourceStream source_stream{s, i};
+            auto tk = source_stream.token();
+            i = source_stream.i;
+            return tk;
+        }
+
+        template<typename Scanner, typename Fn>
+        [[gnu::always_inline]] inline void scan_all(std::string_view s, Fn& fn) {
+            // one scanner for the whole input, so a block classified for one token serves the next ones too
+            Scanner scanner;
+            size_t i = 0;
+            size_t from = 0;
+            for (auto tk = scan_token(scanner, s, i, from); !tk.is_end(); tk = scan_token(scanner, s, i, from)) {
+                fn(tk, from);
+            }
+        }
+
+        template<typename Fn>
+        [[gnu::flatten]] inline void scan_all_scalar(std::string_view s, Fn& fn) {
+            scan_all<ScalarScanner>(s, fn);
+        }
+
+#if META_RUNTIME_X86
+        template<typename Fn>
+        [[gnu::flatten]] __attribute__((target("sse4.2"))) inline void scan_all_sse42(std::string_view s, Fn& fn) {
+            scan_all<Sse42Scanner>(s, fn);
+        }
+
+        template<typename Fn>
+        [[gnu::flatten]] __attribute__((target("avx2"))) inline void scan_all_avx2(std::string_view s, Fn& fn) {
+            scan_all<Avx2Scanner>(s, fn);
+        }
+
+        [[gnu::flatten]] __attribute__((target("sse4.2"))) inline auto scan_token_sse42(std::string_view s, size_t& i, size_t& from) -> Token {
+            Sse42Scanner scanner;
+            return scan_token(scanner, s, i, from);
+        }
+
+        [[gnu::flatten]] __attribute__((target("avx2"))) inline auto scan_token_avx2(std::string_view s, size_t& i, size_t& from) -> Token {
+            // the caller may move `s` and `i` between tokens, a block is only reused within one token
+            Avx2Scanner scanner;
+            return scan_token(scanner, s, i, from);
+        }
+#endif
+    }
+
+    /**
+     * Tokenizes the whole input, calling fn(Token, offset) for every token. Produces exactly the tokens
+     * SourceStream would, using the widest scanner the cpu supports unless `isa` says otherwise.
+     **/
+    template<typename Fn>
+    void scan_tokens(std::string_view s, Fn&& fn, Isa isa = best_isa()) {
+        switch (isa) {
+#if META_RUNTIME_X86
+            case Isa::Avx2:
+                return detail::scan_all_avx2(s, fn);
+            case Isa::Sse42:
+                return detail::scan_all_sse42(s, fn);
+#endif
+            default:
+                return detail::scan_all_scalar(s, fn);
+        }
+    }
+
+    /** drop-in SourceStream replacement for token-at-a-time consumers, `from` is the offset of the last token **/
+    struct FastSourceStream {
+        std::string_view s;
+        size_t i = 0;
+        size_t from = 0;
+        Isa isa = best_isa();
+
+        auto token() -> Token {
+            switch (isa) {
+#if META_RUNTIME_X86
+                case Isa::Avx2:
+                    return detail::scan_token_avx2(s, i, from);
+                case Isa::Sse42:
+                    return detail::scan_token_sse42(s, i, from);
+#endif
+                default: {
+                    detail::ScalarScanner scanner;
+                    return detail::scan_token(scanner, s, i, from);
+                }
+            }
+        }
+    };
+}
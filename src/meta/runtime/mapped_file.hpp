@@ -0,0 +1,109 @@
+//
+// Created by Maksym Pasichnyk on 19.10.2026.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <expected>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace meta::runtime {
+    /** read-only memory mapping of a whole file, pages are loaded by the kernel on first access **/
+    class MappedFile {
+    public:
+        MappedFile() = default;
+
+        MappedFile(MappedFile&& other) noexcept
+            : data(std::exchange(other.data, nullptr))
+            , length(std::exchange(other.length, 0))
+            , released(std::exchange(other.released, 0)) {}
+
+        auto operator=(MappedFile&& other) noexcept -> MappedFile& {
+            if (this != &other) {
+                unmap();
+                data = std::exchange(other.data, nullptr);
+                length = std::exchange(other.length, 0);
+                released = std::exchange(other.released, 0);
+            }
+            return *this;
+        }
+
+        ~MappedFile() {
+            unmap();
+        }
+
+        static auto open(const char* path) -> std::expected<MappedFile, std::error_code> {
+            auto fd = ::open(path, O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                return std::unexpected(std::error_code(errno, std::system_category()));
+            }
+
+            struct stat st{};
+            if (::fstat(fd, &st) != 0) {
+                auto error = std::error_code(errno, std::system_category());
+                ::close(fd);
+                return std::unexpected(error);
+            }
+
+            MappedFile file;
+            if (st.st_size > 0) {
+                auto* ptr = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                if (ptr == MAP_FAILED) {
+                    auto error = std::error_code(errno, std::system_category());
+                    ::close(fd);
+                    return std::unexpected(error);
+                }
+                ::madvise(ptr, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+                file.data = static_cast<const char*>(ptr);
+                file.length = static_cast<size_t>(st.st_size);
+            }
+            // the mapping keeps the file alive
+            ::close(fd);
+            return file;
+        }
+
+        [[nodiscard]] auto view() const -> std::string_view {
+            return {data, length};
+        }
+
+        [[nodiscard]] auto size() const -> size_t {
+            return length;
+        }
+
+        /**
+         * drops the resident pages that lie entirely before `offset`, so a sequential reader keeps a constant
+         * footprint; the mapping stays valid and dropped pages are read back from the file if touched again
+         **/
+        void release_before(size_t offset) {
+            auto page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+            auto end = std::min(offset, length) / page * page;
+            if (end > released) {
+                ::madvise(const_cast<char*>(data) + released, end - released, MADV_DONTNEED);
+                released = end;
+            }
+        }
+
+    private:
+        void unmap() {
+            if (data != nullptr) {
+                ::munmap(const_cast<char*>(data), length);
+            }
+            data = nullptr;
+            length = 0;
+            released = 0;
+        }
+
+        const char* data = nullptr;
+        size_t length = 0;
+        size_t released = 0;
+    };
+}
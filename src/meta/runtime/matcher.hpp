@@ -0,0 +1,766 @@
+//
+// Created by Maksym Pasichnyk on 19.10.2026.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../meta.hpp"
+#include "metrics.hpp"
+
+namespace meta::runtime {
+    enum class MatchOp : uint8_t {
+        Token,  // consumes one token of `type` (and `id` if check_id), then goes to the next state
+        Split,  // continues at both x and y, x first
+        Jump,   // continues at x
+        Save,   // records the start (y == 0) or the end (y == 1) of capture slot x
+        Call,   // enters rule y, which starts at x, and comes back to the next state when it exits
+        Exit,   // end of rule x: returns if the rule was called, otherwise goes to the next state
+        Match,  // the whole pattern matched
+    };
+
+    struct MatchState {
+        MatchOp op = MatchOp::Match;
+        TokenType type = TokenType::End;
+        bool check_id = false;
+        uint32_t x = 0;
+        uint32_t y = 0;
+        size_t id = 0;
+    };
+
+    /** flat state table of a pattern, names[slot] is the fnv1a hash of the fragment captured into that slot **/
+    template<size_t States, size_t Names>
+    struct MatchTable {
+        std::array<MatchState, States> states;
+        std::array<size_t, Names> names;
+    };
+
+    /** `$name:spec` fragment matched by tokens[begin..end) **/
+    struct Capture {
+        size_t name;
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    namespace detail {
+        template<typename T>
+        inline constexpr char rule_tag = 0;
+
+        template<typename T>
+        struct is_combinator : std::false_type {};
+
+        template<TokenType type>
+        struct is_combinator<meta::parse::token<type>> : std::true_type {};
+
+        template<size_t id>
+        struct is_combinator<meta::parse::ident<id>> : std::true_type {};
+
+        template<typename... T>
+        struct is_combinator<meta::parse::group<T...>> : std::true_type {};
+
+        template<typename T>
+        struct is_combinator<meta::parse::opt<T>> : std::true_type {};
+
+        template<typename T>
+        struct is_combinator<meta::parse::list<T>> : std::true_type {};
+
+        template<typename T>
+        struct is_combinator<meta::parse::list_non_empty<T>> : std::true_type {};
+
+        template<typename... T>
+        struct is_combinator<meta::parse::one_of<T...>> : std::true_type {};
+
+        template<size_t id, typename T>
+        struct is_combinator<meta::parse::with_name<id, T>> : std::true_type {};
+
+        struct TableBuilder {
+            std::vector<MatchState> states;
+            std::vector<size_t> names;
+            std::vector<const void*> rules;
+            std::vector<uint32_t> entries;
+
+            constexpr auto here() const -> uint32_t {
+                return static_cast<uint32_t>(states.size());
+            }
+
+            constexpr auto emit(MatchState state) -> uint32_t {
+                states.emplace_back(state);
+                return here() - 1;
+            }
+
+            constexpr auto slot(size_t name) -> uint32_t {
+                for (size_t i = 0; i < names.size(); ++i) {
+                    if (names[i] == name) {
+                        return static_cast<uint32_t>(i);
+                    }
+                }
+                names.emplace_back(name);
+                return static_cast<uint32_t>(names.size() - 1);
+            }
+
+            constexpr auto follow(uint32_t pc) const -> uint32_t {
+                for (size_t hops = 0; states[pc].op == MatchOp::Jump && hops < states.size(); ++hops) {
+                    pc = states[pc].x;
+                }
+                return pc;
+            }
+
+            constexpr auto called(uint32_t rule) const -> bool {
+                for (const auto& state : states) {
+                    if (state.op == MatchOp::Call && state.y == rule) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            /**
+             * Exits of rules that are never called fall straight through, and a call whose continuation is
+             * the callee's own exit is a loop. Both are repeated until nothing changes, then jump chains are
+             * shortcut so the matcher follows fewer epsilon edges.
+             **/
+            constexpr void optimize() {
+                for (bool changed = true; changed;) {
+                    changed = false;
+                    for (uint32_t pc = 0; pc < here(); ++pc) {
+                        auto& state = states[pc];
+                        if (state.op == MatchOp::Exit && !called(state.x)) {
+                            state = MatchState{.op = MatchOp::Jump, .x = pc + 1};
+                            changed = true;
+                        }
+                        if (state.op == MatchOp::Call) {
+                            const auto& next = states[follow(pc + 1)];
+                            if (next.op == MatchOp::Exit && next.x == state.y) {
+                                state = MatchState{.op = MatchOp::Jump, .x = state.x};
+                                changed = true;
+                            }
+                        }
+                    }
+                }
+                for (auto& state : states) {
+                    if (state.op == MatchOp::Split || state.op == MatchOp::Jump || state.op == MatchOp::Call) {
+                        state.x = follow(state.x);
+                    }
+                    if (state.op == MatchOp::Split) {
+                        state.y = follow(state.y);
+                    }
+                }
+            }
+        };
+
+        template<typename T>
+        constexpr void lower_rule(TableBuilder& builder);
+
+        template<TokenType type>
+        constexpr void lower(TableBuilder& builder, const meta::parse::token<type>*) {
+            builder.emit(MatchState{.op = MatchOp::Token, .type = type});
+        }
+
+        template<size_t id>
+        constexpr void lower(TableBuilder& builder, const meta::parse::ident<id>*) {
+            builder.emit(MatchState{.op = MatchOp::Token, .type = TokenType::Identifier, .check_id = true, .id = id});
+        }
+
+        template<typename... T>
+        constexpr void lower(TableBuilder& builder, const meta::parse::group<T...>*) {
+            (lower_rule<T>(builder), ...);
+        }
+
+        template<typename T>
+        constexpr void lower(TableBuilder& builder, const meta::parse::opt<T>*) {
+            auto split = builder.emit(MatchState{.op = MatchOp::Split});
+            lower_rule<T>(builder);
+            builder.states[split].x = split + 1;
+            builder.states[split].y = builder.here();
+        }
+
+        template<typename T>
+        constexpr void lower(TableBuilder& builder, const meta::parse::list<T>*) {
+            auto split = builder.emit(MatchState{.op = MatchOp::Split});
+            lower_rule<T>(builder);
+            builder.emit(MatchState{.op = MatchOp::Jump, .x = split});
+            builder.states[split].x = split + 1;
+            builder.states[split].y = builder.here();
+        }
+
+        template<typename T>
+        constexpr void lower(TableBuilder& builder, const meta::parse::list_non_empty<T>*) {
+            auto start = builder.here();
+            lower_rule<T>(builder);
+            builder.emit(MatchState{.op = MatchOp::Split, .x = start, .y = builder.here() + 1});
+        }
+
+        template<typename... T>
+        constexpr void lower(TableBuilder& builder, const meta::parse::one_of<T...>*) {
+            std::vector<uint32_t> jumps;
+            auto alternative = [&]<typename U>(bool last) {
+                auto split = last ? builder.here() : builder.emit(MatchState{.op = MatchOp::Split});
+                lower_rule<U>(builder);
+                if (!last) {
+                    jumps.emplace_back(builder.emit(MatchState{.op = MatchOp::Jump}));
+                    builder.states[split].x = split + 1;
+                    builder.states[split].y = builder.here();
+                }
+            };
+            size_t index = 0;
+            (alternative.template operator()<T>(++index == sizeof...(T)), ...);
+            for (auto jump : jumps) {
+                builder.states[jump].x = builder.here();
+            }
+        }
+
+        template<size_t id, typename T>
+        constexpr void lower(TableBuilder& builder, const meta::parse::with_name<id, T>*) {
+            auto slot = builder.slot(id);
+            builder.emit(MatchState{.op = MatchOp::Save, .x = slot, .y = 0});
+            lower_rule<T>(builder);
+            builder.emit(MatchState{.op = MatchOp::Save, .x = slot, .y = 1});
+        }
+
+        /**
+         * Combinators are expanded in place. A named rule (a struct deriving from a combinator, or exposing its
+         * combinator as `rule`) is expanded once, every later use calls into that copy, so recursive rules such
+         * as Expression stay finite.
+         **/
+        template<typename T>
+        constexpr void lower_rule(TableBuilder& builder) {
+            if constexpr (is_combinator<T>::value) {
+                lower(builder, static_cast<const T*>(nullptr));
+            } else {
+                const void* tag = &rule_tag<T>;
+                for (size_t i = 0; i < builder.rules.size(); ++i) {
+                    if (builder.rules[i] == tag) {
+                        builder.emit(MatchState{.op = MatchOp::Call, .x = builder.entries[i], .y = static_cast<uint32_t>(i)});
+                        return;
+                    }
+                }
+                auto rule = static_cast<uint32_t>(builder.rules.size());
+                builder.rules.emplace_back(tag);
+                builder.entries.emplace_back(builder.here());
+                if constexpr (requires { typename T::rule; }) {
+                    lower_rule<typename T::rule>(builder);
+                } else {
+                    lower(builder, static_cast<const T*>(nullptr));
+                }
+                builder.emit(MatchState{.op = MatchOp::Exit, .x = rule});
+            }
+        }
+
+        template<typename Rule>
+        consteval auto build_table() -> TableBuilder {
+            TableBuilder builder;
+            lower_rule<Rule>(builder);
+            builder.emit(MatchState{.op = MatchOp::Match});
+            builder.optimize();
+            return builder;
+        }
+
+        template<typename Rule>
+        consteval auto make_match_table() {
+            constexpr auto states = build_table<Rule>().states.size();
+            constexpr auto names = build_table<Rule>().names.size();
+
+            auto builder = build_table<Rule>();
+            MatchTable<states, names> table{};
+            std::copy(builder.states.begin(), builder.states.end(), table.states.begin());
+            std::copy(builder.names.begin(), builder.names.end(), table.names.begin());
+            return table;
+        }
+    }
+
+    /**
+     * State table of a combinator pattern, e.g. `match_table<macro_rules(($($param:ident)*) -> $body:expr)>`.
+     * The table accepts the language of the pattern read as a grammar: where the combinators would commit to
+     * the first alternative or to the longest repetition and then fail, the table still tries the others.
+     * For patterns that never need to take such a choice back (the usual case) both accept the same inputs.
+     **/
+    template<typename Rule>
+    inline constexpr auto match_table = detail::make_match_table<Rule>();
+
+    /**
+     * Runs a MatchTable over runtime token streams. All alternatives advance together one token at a time
+     * (a Pike VM), so the input is read once and nothing is backtracked. Return points of called rules live
+     * in a graph-structured stack: every caller entering rule R at the same position shares one node, which
+     * keeps the number of live threads bounded by the table size however ambiguous the nesting gets.
+     * Only patterns without calls run at a few nanoseconds per token: they go through a lazily built DFA,
+     * ~4 ns/token for the message pattern in meta-bench-matcher. Recursive patterns stay on the Pike VM, and
+     * the Function pattern measures ~185 ns/token there, several times slower than compile_tokens on the same input.
+     * A Matcher reuses its buffers between calls and is not thread-safe. It reads the states of its table in
+     * place, so the table has to outlive it; match_table<Rule> always does, a temporary never does.
+     **/
+    class Matcher {
+    public:
+        template<size_t States, size_t Names>
+        explicit Matcher(const MatchTable<States, Names>& table) : states(table.states), names(table.names), seen(States, 0) {
+            // epsilon closures over Split / Jump, in the order the alternatives are tried
+            std::vector<uint32_t> marks(States, 0);
+            for (uint32_t pc = 0; pc < States; ++pc) {
+                closure_begin.emplace_back(static_cast<uint32_t>(closure.size()));
+                work.emplace_back(Thread{pc, 0, 0});
+                while (!work.empty()) {
+                    auto at = work.back().pc;
+                    work.pop_back();
+                    if (std::exchange(marks[at], pc + 1) == pc + 1) {
+                        continue;
+                    }
+                    const auto& state = states[at];
+                    if (state.op == MatchOp::Jump) {
+                        work.emplace_back(Thread{state.x, 0, 0});
+                    } else if (state.op == MatchOp::Split) {
+                        work.emplace_back(Thread{state.y, 0, 0});
+                        work.emplace_back(Thread{state.x, 0, 0});
+                    } else {
+                        closure.emplace_back(at);
+                    }
+                }
+            }
+            closure_begin.emplace_back(static_cast<uint32_t>(closure.size()));
+
+            dfa.enabled = std::none_of(states.begin(), states.end(), [](const auto& state) {
+                return state.op == MatchOp::Call;
+            });
+            for (const auto& state : states) {
+                if (state.check_id && std::find(dfa.ids.begin(), dfa.ids.end(), state.id) == dfa.ids.end()) {
+                    dfa.ids.emplace_back(state.id);
+                }
+            }
+        }
+
+        template<size_t States, size_t Names>
+        explicit Matcher(const MatchTable<States, Names>&&) = delete;
+
+        /** true if the whole token stream matches **/
+        auto match(std::span<const Token> tokens) -> bool {
+            detail::ParseScope scope(Grammar::Pattern);
+            auto matched = match_verdict(tokens);
+            scope.done(matched, tokens.size());
+            return matched;
+        }
+
+        /** same, and on success fills `captures` with every captured fragment in input order **/
+        auto match(std::span<const Token> tokens, std::vector<Capture>& captures) -> bool {
+            detail::ParseScope scope(Grammar::Pattern);
+            auto matched = match_captures(tokens, captures);
+            scope.done(matched, tokens.size());
+            return matched;
+        }
+
+    private:
+        auto match_verdict(std::span<const Token> tokens) -> bool {
+            if (dfa.enabled) {
+                if (auto verdict = dfa_match(tokens)) {
+                    return *verdict;
+                }
+            }
+            return run<false>(tokens) != nullptr;
+        }
+
+        auto match_captures(std::span<const Token> tokens, std::vector<Capture>& captures) -> bool {
+            captures.clear();
+            // most rejected inputs never get to the slower pass that records captures
+            if (dfa.enabled && dfa_match(tokens) == false) {
+                return false;
+            }
+            const auto* winner = run<true>(tokens);
+            if (winner == nullptr) {
+                return false;
+            }
+            // the log is a tree of splices, walk it newest first and replay it backwards
+            trail.clear();
+            pending.clear();
+            for (auto log = winner->log; log != 0 || !pending.empty();) {
+                if (log == 0) {
+                    log = pending.back();
+                    pending.pop_back();
+                    continue;
+                }
+                const auto& event = events[log - 1];
+                if (event.mark == Mark::Splice) {
+                    pending.emplace_back(event.parent);
+                    log = event.inner;
+                } else {
+                    trail.emplace_back(log - 1);
+                    log = event.parent;
+                }
+            }
+            open.clear();
+            for (auto it = trail.rbegin(); it != trail.rend(); ++it) {
+                const auto& event = events[*it];
+                if (event.mark == Mark::Close) {
+                    captures[open.back()].end = event.pos;
+                    open.pop_back();
+                } else {
+                    open.emplace_back(captures.size());
+                    captures.emplace_back(Capture{names[event.slot], event.pos, event.pos});
+                }
+            }
+            return true;
+        }
+
+        // node, edge and log are 1-based indices into nodes / edges / events, 0 is the bottom of the stack / none / the empty log
+        struct Thread {
+            uint32_t pc;
+            uint32_t node;
+            uint32_t log;
+        };
+
+        /** one activation of `rule` that started at `pos`, shared by every caller that entered it there **/
+        struct Node {
+            uint32_t rule;
+            uint32_t pos;
+            uint32_t edges;
+            bool popped;
+            uint32_t pop_log;
+        };
+
+        /** a caller of a node: where to continue, on which stack, and the caller's log so far **/
+        struct Edge {
+            uint32_t ret;
+            uint32_t node;
+            uint32_t log;
+            uint32_t next;
+        };
+
+        enum class Mark : uint8_t {
+            Open,
+            Close,
+            Splice,
+        };
+
+        /** threads only log what happened since their node started, a splice appends a callee's log to its caller's **/
+        struct Event {
+            uint32_t parent;
+            uint32_t inner;
+            uint32_t pos;
+            uint32_t slot;
+            Mark mark;
+        };
+
+        /** open addressing map of 64-bit keys, cleared in O(1) by bumping the stamp, in O(n) once it wraps **/
+        struct StampedMap {
+            struct Slot {
+                uint64_t key;
+                uint32_t stamp;
+                uint32_t value;
+            };
+            std::vector<Slot> slots = std::vector<Slot>(64);
+            uint32_t stamp = 1;
+            size_t count = 0;
+
+            void clear() {
+                // after 2^32 clears old slots would carry the current stamp again
+                if (++stamp == 0) {
+                    for (auto& slot : slots) {
+                        slot.stamp = 0;
+                    }
+                    stamp = 1;
+                }
+                count = 0;
+            }
+
+            /** returns the value stored for `key`, inserting `value` if the key is new **/
+            auto insert(uint64_t key, uint32_t value) -> std::pair<uint32_t, bool> {
+                if (2 * (count + 1) > slots.size()) {
+                    grow();
+                }
+                auto mask = slots.size() - 1;
+                for (auto i = hash(key) & mask;; i = (i + 1) & mask) {
+                    auto& slot = slots[i];
+                    if (slot.stamp != stamp) {
+                        slot = Slot{key, stamp, value};
+                        count += 1;
+                        return {value, true};
+                    }
+                    if (slot.key == key) {
+                        return {slot.value, false};
+                    }
+                }
+            }
+
+            void grow() {
+                auto old = std::exchange(slots, std::vector<Slot>(slots.size() * 2));
+                count = 0;
+                for (const auto& slot : old) {
+                    if (slot.stamp == stamp) {
+                        insert(slot.key, slot.value);
+                    }
+                }
+            }
+
+            static auto hash(uint64_t key) -> size_t {
+                key *= 0x9E3779B97F4A7C15ull;
+                return static_cast<size_t>(key ^ (key >> 32));
+            }
+        };
+
+        auto log_event(Event event) -> uint32_t {
+            events.emplace_back(event);
+            return static_cast<uint32_t>(events.size());
+        }
+
+        auto splice(uint32_t caller, uint32_t callee) -> uint32_t {
+            return callee == 0 ? caller : log_event(Event{caller, callee, 0, 0, Mark::Splice});
+        }
+
+        /**
+         * Lazily built DFA used when the pattern has no calls. Every row is a set of NFA states seen so far,
+         * row 0 is the empty (dead) set. Past max_rows the DFA is dropped and run() does all the matching.
+         **/
+        struct Dfa {
+            static constexpr size_t token_types = static_cast<size_t>(TokenType::RightBrace) + 1;
+            static constexpr size_t max_rows = 4096;
+            static constexpr int32_t unknown = -1;
+
+            bool enabled = false;
+            // identifiers the pattern looks for, each one is a symbol of its own
+            std::vector<size_t> ids;
+            std::vector<int32_t> delta;
+            std::vector<uint8_t> accepting;
+            std::vector<std::vector<uint32_t>> sets;
+            std::map<std::vector<uint32_t>, int32_t> rows;
+            std::vector<uint32_t> marks;
+            uint32_t stamp = 0;
+            int32_t start = unknown;
+
+            [[nodiscard]] auto symbols() const -> size_t {
+                return token_types + ids.size();
+            }
+
+            [[nodiscard]] auto symbol(const Token& tk) const -> size_t {
+                if (tk.is(TokenType::Identifier)) {
+                    for (size_t i = 0; i < ids.size(); ++i) {
+                        if (ids[i] == tk.id) {
+                            return token_types + i;
+                        }
+                    }
+                }
+                return static_cast<size_t>(tk.type);
+            }
+        };
+
+        /** adds the NFA states reachable from `from` to `set`, captures do not matter for the verdict **/
+        void dfa_closure(uint32_t from, std::vector<uint32_t>& set) {
+            trail.emplace_back(from);
+            while (!trail.empty()) {
+                auto pc = trail.back();
+                trail.pop_back();
+                for (auto i = closure_begin[pc]; i < closure_begin[pc + 1]; ++i) {
+                    auto at = closure[i];
+                    if (std::exchange(dfa.marks[at], dfa.stamp) == dfa.stamp) {
+                        continue;
+                    }
+                    if (states[at].op == MatchOp::Save) {
+                        trail.emplace_back(at + 1);
+                    } else {
+                        set.emplace_back(at);
+                    }
+                }
+            }
+        }
+
+        auto dfa_row(std::vector<uint32_t> set) -> int32_t {
+            std::sort(set.begin(), set.end());
+            if (auto it = dfa.rows.find(set); it != dfa.rows.end()) {
+                return it->second;
+            }
+            if (dfa.sets.size() >= Dfa::max_rows) {
+                return Dfa::unknown;
+            }
+            auto row = static_cast<int32_t>(dfa.sets.size());
+            auto accepting = std::any_of(set.begin(), set.end(), [&](auto pc) {
+                return states[pc].op == MatchOp::Match;
+            });
+            dfa.rows.emplace(set, row);
+            dfa.sets.emplace_back(std::move(set));
+            dfa.accepting.emplace_back(accepting);
+            dfa.delta.resize(dfa.sets.size() * dfa.symbols(), Dfa::unknown);
+            return row;
+        }
+
+        auto dfa_step(int32_t row, const Token& tk) -> int32_t {
+            std::vector<uint32_t> set;
+            dfa.stamp += 1;
+            for (auto pc : dfa.sets[row]) {
+                const auto& state = states[pc];
+                if (state.op == MatchOp::Token && state.type == tk.type && (!state.check_id || state.id == tk.id)) {
+                    dfa_closure(pc + 1, set);
+                }
+            }
+            return dfa_row(std::move(set));
+        }
+
+        /** the verdict, or nothing if the DFA grew too large and was dropped **/
+        auto dfa_match(std::span<const Token> tokens) -> std::optional<bool> {
+            if (dfa.start == Dfa::unknown) {
+                dfa.marks.assign(states.size(), 0);
+                dfa_row({});
+                std::vector<uint32_t> set;
+                dfa.stamp += 1;
+                dfa_closure(0, set);
+                dfa.start = dfa_row(std::move(set));
+            }
+            auto row = dfa.start;
+            for (const auto& tk : tokens) {
+                auto& next = dfa.delta[row * dfa.symbols() + dfa.symbol(tk)];
+                if (next == Dfa::unknown) {
+                    auto built = dfa_step(row, tk);
+                    if (built == Dfa::unknown) {
+                        dfa.enabled = false;
+                        return std::nullopt;
+                    }
+                    // dfa_step may have grown the table, `next` is stale
+                    dfa.delta[row * dfa.symbols() + dfa.symbol(tk)] = built;
+                    row = built;
+                } else {
+                    row = next;
+                }
+                if (row == 0) {
+                    return false;
+                }
+            }
+            return dfa.accepting[row] != 0;
+        }
+
+        /** queues the states `thread` reaches through Split / Jump, first alternative on top **/
+        void push(Thread thread) {
+            for (auto i = closure_begin[thread.pc + 1]; i-- > closure_begin[thread.pc];) {
+                work.emplace_back(Thread{closure[i], thread.node, thread.log});
+            }
+        }
+
+        /** adds `thread` and everything reachable from it without consuming a token **/
+        template<bool Captures>
+        void add(std::vector<Thread>& list, Thread thread, uint32_t pos) {
+            push(thread);
+            while (!work.empty()) {
+                auto t = work.back();
+                work.pop_back();
+
+                // threads outside of any call, the only kind in patterns without recursion, skip the hash map
+                if (t.node == 0 ? std::exchange(seen[t.pc], generation) == generation : !visited.insert(uint64_t(t.pc) << 32 | t.node, 0).second) {
+                    continue;
+                }
+                const auto& state = states[t.pc];
+                switch (state.op) {
+                    case MatchOp::Jump:
+                    case MatchOp::Split:
+                        // never queued, push() expands them
+                        break;
+                    case MatchOp::Save:
+                        if constexpr (Captures) {
+                            t.log = log_event(Event{t.log, 0, pos, state.x, state.y == 0 ? Mark::Open : Mark::Close});
+                        }
+                        push(Thread{t.pc + 1, t.node, t.log});
+                        break;
+                    case MatchOp::Call: {
+                        auto [index, created] = calls.insert(state.y, static_cast<uint32_t>(nodes.size() + 1));
+                        if (created) {
+                            nodes.emplace_back(Node{state.y, pos, 0, false, 0});
+                        }
+                        auto& node = nodes[index - 1];
+                        edges.emplace_back(Edge{t.pc + 1, t.node, t.log, node.edges});
+                        node.edges = static_cast<uint32_t>(edges.size());
+                        if (created) {
+                            push(Thread{state.x, index, 0});
+                        } else if (node.popped) {
+                            // the rule already matched nothing here, so the new caller can continue right away
+                            push(Thread{t.pc + 1, t.node, Captures ? splice(t.log, node.pop_log) : 0});
+                        }
+                        break;
+                    }
+                    case MatchOp::Exit: {
+                        if (t.node == 0 || nodes[t.node - 1].rule != state.x) {
+                            push(Thread{t.pc + 1, t.node, t.log});
+                            break;
+                        }
+                        auto& node = nodes[t.node - 1];
+                        if (node.pos == pos && !node.popped) {
+                            node.popped = true;
+                            node.pop_log = t.log;
+                        }
+                        for (auto e = node.edges; e != 0; e = edges[e - 1].next) {
+                            const auto& edge = edges[e - 1];
+                            push(Thread{edge.ret, edge.node, Captures ? splice(edge.log, t.log) : 0});
+                        }
+                        break;
+                    }
+                    case MatchOp::Token:
+                    case MatchOp::Match:
+                        list.emplace_back(t);
+                        break;
+                }
+            }
+        }
+
+        void next_generation() {
+            // one generation per token, on a long-lived Matcher the counter wraps and old marks would look current
+            if (++generation == 0) {
+                std::fill(seen.begin(), seen.end(), 0);
+                generation = 1;
+            }
+            visited.clear();
+            calls.clear();
+        }
+
+        template<bool Captures>
+        auto run(std::span<const Token> tokens) -> const Thread* {
+            nodes.clear();
+            edges.clear();
+            events.clear();
+            current.clear();
+
+            next_generation();
+            add<Captures>(current, Thread{0, 0, 0}, 0);
+            for (uint32_t pos = 0; pos < tokens.size(); ++pos) {
+                const auto& tk = tokens[pos];
+                next.clear();
+                next_generation();
+                for (const auto& t : current) {
+                    const auto& state = states[t.pc];
+                    if (state.op == MatchOp::Token && state.type == tk.type && (!state.check_id || state.id == tk.id)) {
+                        add<Captures>(next, Thread{t.pc + 1, t.node, t.log}, pos + 1);
+                    }
+                }
+                std::swap(current, next);
+                if (current.empty()) {
+                    return nullptr;
+                }
+            }
+            for (const auto& t : current) {
+                if (states[t.pc].op == MatchOp::Match && t.node == 0) {
+                    return &t;
+                }
+            }
+            return nullptr;
+        }
+
+        std::span<const MatchState> states;
+        std::span<const size_t> names;
+
+        std::vector<Thread> current;
+        std::vector<Thread> next;
+        std::vector<Thread> work;
+        std::vector<Node> nodes;
+        std::vector<Edge> edges;
+        std::vector<Event> events;
+        std::vector<uint32_t> trail;
+        std::vector<uint32_t> pending;
+        std::vector<size_t> open;
+        std::vector<uint32_t> seen;
+        std::vector<uint32_t> closure_begin;
+        std::vector<uint32_t> closure;
+        uint32_t generation = 0;
+        Dfa dfa;
+        StampedMap visited;
+        StampedMap calls;
+    };
+}
@@ -0,0 +1,375 @@
+//
+// Created by Maksym Pasichnyk on 19.10.2026.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory_resource>
+#include <mutex>
+
+/**
+ * Configure with -DMETA_RUNTIME_METRICS=ON to record parse latencies, tokens, scratch arena bytes, cache hits and
+ * executed opcodes. Otherwise every hook below is an empty inline function and metrics_snapshot() is all zeros.
+ * The switch changes the bodies of inline functions such as evaluate() and compile(), so it has to be the same
+ * for the whole program; the CMake option sets it on the meta target, never define it in a single file.
+ **/
+#ifndef META_RUNTIME_METRICS
+#define META_RUNTIME_METRICS 0
+#endif
+
+namespace meta::runtime {
+    static constexpr bool metrics_enabled = META_RUNTIME_METRICS != 0;
+
+    /** the runtime parsers, each gets its own histogram **/
+    enum class Grammar : uint8_t {
+        Formula,        // compile() and compile_tokens()
+        Incremental,    // IncrementalCompiler, time spent inside feed() and finish()
+        Pattern,        // Matcher::match()
+    };
+
+    static constexpr size_t grammar_count = 3;
+
+    /** indexed by static_cast<size_t>(OpCode) **/
+    static constexpr size_t opcode_slots = 16;
+
+    inline auto grammar_name(Grammar grammar) -> const char* {
+        switch (grammar) {
+            case Grammar::Formula:
+                return "formula";
+            case Grammar::Incremental:
+                return "incremental";
+            case Grammar::Pattern:
+                return "pattern";
+        }
+        return "?";
+    }
+
+    /**
+     * Log-linear buckets in the style of HdrHistogram: values below 8 are exact, above that every power of two
+     * is split into 8 buckets, so a percentile is reported within 12.5% of the recorded value.
+     **/
+    struct LatencyHistogram {
+        static constexpr size_t sub_bits = 3;
+        static constexpr size_t sub_buckets = size_t(1) << sub_bits;
+        static constexpr size_t bucket_count = (64 - sub_bits + 1) * sub_buckets;
+
+        std::array<uint64_t, bucket_count> counts{};
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        uint64_t max = 0;
+
+        static constexpr auto bucket_of(uint64_t value) -> size_t {
+            if (value < sub_buckets) {
+                return static_cast<size_t>(value);
+            }
+            auto exponent = static_cast<size_t>(std::bit_width(value)) - 1;
+            auto sub = static_cast<size_t>(value >> (exponent - sub_bits)) & (sub_buckets - 1);
+            return (exponent - sub_bits + 1) * sub_buckets + sub;
+        }
+
+        /** smallest value that falls into `bucket` **/
+        static constexpr auto lower_bound(size_t bucket) -> uint64_t {
+            if (bucket < sub_buckets) {
+                return bucket;
+            }
+            auto exponent = bucket / sub_buckets + sub_bits - 1;
+            return (sub_buckets + bucket % sub_buckets) << (exponent - sub_bits);
+        }
+
+        /** largest value of the bucket holding the `p` quantile, p in [0, 1] **/
+        [[nodiscard]] auto percentile(double p) const -> uint64_t {
+            if (count == 0) {
+                return 0;
+            }
+            auto rank = static_cast<uint64_t>(p * double(count - 1)) + 1;
+            uint64_t seen = 0;
+            for (size_t bucket = 0; bucket < bucket_count; ++bucket) {
+                seen += counts[bucket];
+                if (seen >= rank) {
+                    return bucket + 1 < bucket_count ? std::min(max, lower_bound(bucket + 1) - 1) : max;
+                }
+            }
+            return max;
+        }
+
+        [[nodiscard]] auto mean() const -> double {
+            return count == 0 ? 0.0 : double(sum) / double(count);
+        }
+    };
+
+    struct GrammarMetrics {
+        LatencyHistogram latency;   // nanoseconds per parse
+        uint64_t failures = 0;
+        uint64_t tokens = 0;
+
+        /** tokens per second of parsing time **/
+        [[nodiscard]] auto tokens_per_second() const -> double {
+            return latency.sum == 0 ? 0.0 : double(tokens) * 1e9 / double(latency.sum);
+        }
+    };
+
+    struct MetricsSnapshot {
+        std::array<GrammarMetrics, grammar_count> grammars{};
+        uint64_t arena_bytes = 0;       // scratch requested by compile() and compile_tokens()
+        uint64_t cache_hits = 0;
+        uint64_t cache_misses = 0;
+        uint64_t evaluations = 0;       // evaluate() calls plus evaluate_batch() rows
+        std::array<uint64_t, opcode_slots> opcodes{};
+
+        [[nodiscard]] auto operator[](Grammar grammar) const -> const GrammarMetrics& {
+            return grammars[static_cast<size_t>(grammar)];
+        }
+
+        [[nodiscard]] auto cache_hit_rate() const -> double {
+            auto lookups = cache_hits + cache_misses;
+            return lookups == 0 ? 0.0 : double(cache_hits) / double(lookups);
+        }
+    };
+
+#if META_RUNTIME_METRICS
+    namespace detail {
+        /**
+         * Counters of one thread. Only the owner writes them, so an update is a relaxed load and store
+         * rather than a locked read-modify-write, and snapshots read them without stopping anyone.
+         **/
+        struct alignas(64) MetricsShard {
+            struct GrammarCounters {
+                std::array<std::atomic<uint64_t>, LatencyHistogram::bucket_count> buckets{};
+                std::atomic<uint64_t> count{0};
+                std::atomic<uint64_t> sum{0};
+                std::atomic<uint64_t> max{0};
+                std::atomic<uint64_t> failures{0};
+                std::atomic<uint64_t> tokens{0};
+            };
+
+            std::array<GrammarCounters, grammar_count> grammars{};
+            std::atomic<uint64_t> arena_bytes{0};
+            std::atomic<uint64_t> cache_hits{0};
+            std::atomic<uint64_t> cache_misses{0};
+            std::atomic<uint64_t> evaluations{0};
+            std::array<std::atomic<uint64_t>, opcode_slots> opcodes{};
+            bool in_use = false;
+        };
+
+        inline void bump(std::atomic<uint64_t>& counter, uint64_t n = 1) {
+            counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+        /** shards outlive their threads and are handed to the next thread, totals stay cumulative **/
+        class MetricsRegistry {
+        public:
+            auto acquire() -> MetricsShard* {
+                std::lock_guard lock(mutex);
+                for (auto& shard : shards) {
+                    if (!shard.in_use) {
+                        shard.in_use = true;
+                        return &shard;
+                    }
+                }
+                auto& shard = shards.emplace_back();
+                shard.in_use = true;
+                return &shard;
+            }
+
+            void release(MetricsShard* shard) {
+                std::lock_guard lock(mutex);
+                shard->in_use = false;
+            }
+
+            auto snapshot() -> MetricsSnapshot {
+                MetricsSnapshot snapshot{};
+                std::lock_guard lock(mutex);
+                for (const auto& shard : shards) {
+                    for (size_t g = 0; g < grammar_count; ++g) {
+                        const auto& from = shard.grammars[g];
+                        auto& to = snapshot.grammars[g];
+                        for (size_t b = 0; b < LatencyHistogram::bucket_count; ++b) {
+                            to.latency.counts[b] += from.buckets[b].load(std::memory_order_relaxed);
+                        }
+                        to.latency.count += from.count.load(std::memory_order_relaxed);
+                        to.latency.sum += from.sum.load(std::memory_order_relaxed);
+                        to.latency.max = std::max(to.latency.max, from.max.load(std::memory_order_relaxed));
+                        to.failures += from.failures.load(std::memory_order_relaxed);
+                        to.tokens += from.tokens.load(std::memory_order_relaxed);
+                    }
+                    snapshot.arena_bytes += shard.arena_bytes.load(std::memory_order_relaxed);
+                    snapshot.cache_hits += shard.cache_hits.load(std::memory_order_relaxed);
+                    snapshot.cache_misses += shard.cache_misses.load(std::memory_order_relaxed);
+                    snapshot.evaluations += shard.evaluations.load(std::memory_order_relaxed);
+                    for (size_t op = 0; op < opcode_slots; ++op) {
+                        snapshot.opcodes[op] += shard.opcodes[op].load(std::memory_order_relaxed);
+                    }
+                }
+                return snapshot;
+            }
+
+        private:
+            std::mutex mutex;
+            std::deque<MetricsShard> shards;
+        };
+
+        /** never destroyed, threads may still release their shard during static destruction **/
+        inline auto metrics_registry() -> MetricsRegistry& {
+            static auto* registry = new MetricsRegistry();
+            return *registry;
+        }
+
+        inline auto metrics_shard() -> MetricsShard& {
+            struct Owner {
+                MetricsShard* shard = metrics_registry().acquire();
+
+                ~Owner() {
+                    metrics_registry().release(shard);
+                }
+            };
+            thread_local Owner owner;
+            return *owner.shard;
+        }
+
+        inline auto metrics_now() -> uint64_t {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        inline void record_parse(Grammar grammar, uint64_t nanoseconds, size_t tokens, bool ok) {
+            auto& counters = metrics_shard().grammars[static_cast<size_t>(grammar)];
+            bump(counters.buckets[LatencyHistogram::bucket_of(nanoseconds)]);
+            bump(counters.count);
+            bump(counters.sum, nanoseconds);
+            bump(counters.tokens, tokens);
+            if (!ok) {
+                bump(counters.failures);
+            }
+            if (nanoseconds > counters.max.load(std::memory_order_relaxed)) {
+                counters.max.store(nanoseconds, std::memory_order_relaxed);
+            }
+        }
+
+        /** forwards to `upstream` and counts what was asked for **/
+        class CountingResource final : public std::pmr::memory_resource {
+        public:
+            explicit CountingResource(std::pmr::memory_resource* upstream) : upstream(upstream) {}
+
+            uint64_t bytes = 0;
+
+        private:
+            auto do_allocate(size_t size, size_t alignment) -> void* override {
+                bytes += size;
+                return upstream->allocate(size, alignment);
+            }
+
+            void do_deallocate(void* p, size_t size, size_t alignment) override {
+                upstream->deallocate(p, size, alignment);
+            }
+
+            [[nodiscard]] auto do_is_equal(const std::pmr::memory_resource& other) const noexcept -> bool override {
+                return this == &other;
+            }
+
+            std::pmr::memory_resource* upstream;
+        };
+
+        /** times one parse, and when given the scratch resource, counts the arena bytes it uses **/
+        class ParseScope {
+        public:
+            explicit ParseScope(Grammar grammar) : grammar(grammar), counting(nullptr), start(metrics_now()) {}
+
+            ParseScope(Grammar grammar, std::pmr::memory_resource*& scratch) : grammar(grammar), counting(scratch), start(metrics_now()) {
+                scratch = &counting;
+            }
+
+            void done(bool ok, size_t tokens) {
+                record_parse(grammar, metrics_now() - start, tokens, ok);
+                bump(metrics_shard().arena_bytes, counting.bytes);
+            }
+
+        private:
+            Grammar grammar;
+            CountingResource counting;
+            uint64_t start;
+        };
+
+        /** parse time spread over several calls, e.g. every feed() of an incremental parse **/
+        class ParseStopwatch {
+        public:
+            struct Lap {
+                ParseStopwatch& owner;
+
+                ~Lap() {
+                    owner.elapsed += metrics_now() - owner.started;
+                }
+            };
+
+            auto lap() -> Lap {
+                started = metrics_now();
+                return Lap{*this};
+            }
+
+            /** may be called inside a lap, which is then counted up to now **/
+            void done(Grammar grammar, bool ok, size_t tokens) {
+                record_parse(grammar, elapsed + (metrics_now() - started), tokens, ok);
+            }
+
+        private:
+            uint64_t elapsed = 0;
+            uint64_t started = 0;
+        };
+
+        inline void record_cache(bool hit) {
+            auto& shard = metrics_shard();
+            bump(hit ? shard.cache_hits : shard.cache_misses);
+        }
+
+        /** `rows` evaluations of `code`, every instruction runs once per row **/
+        template<typename Code>
+        inline void record_evaluation(const Code& code, uint64_t rows) {
+            auto& shard = metrics_shard();
+            bump(shard.evaluations, rows);
+            for (const auto& instruction : code) {
+                bump(shard.opcodes[static_cast<size_t>(instruction.op)], rows);
+            }
+        }
+    }
+
+    /** sums every thread's counters, safe to call while they are being updated **/
+    inline auto metrics_snapshot() -> MetricsSnapshot {
+        return detail::metrics_registry().snapshot();
+    }
+#else
+    namespace detail {
+        class ParseScope {
+        public:
+            explicit ParseScope(Grammar) {}
+            ParseScope(Grammar, std::pmr::memory_resource*&) {}
+
+            void done(bool, size_t) {}
+        };
+
+        class ParseStopwatch {
+        public:
+            struct Lap {};
+
+            auto lap() -> Lap {
+                return {};
+            }
+
+            void done(Grammar, bool, size_t) {}
+        };
+
+        inline void record_cache(bool) {}
+
+        template<typename Code>
+        inline void record_evaluation(const Code&, uint64_t) {}
+    }
+
+    inline auto metrics_snapshot() -> MetricsSnapshot {
+        return {};
+    }
+#endif
+}
@@ -0,0 +1,47 @@
+//
+// Created by Maksym Pasichnyk on 19.10.2026.
+//
+
+#pragma once
+
+#include <array>
+#include <memory_resource>
+
+#include "compiler.hpp"
+#include "thread_pool.hpp"
+
+namespace meta::runtime {
+    namespace detail {
+        /** snippets per work item, large enough to amortize the deque traffic **/
+        static constexpr size_t parse_grain = 64;
+
+        /** per-worker scratch arena, released after every snippet so its first block is reused **/
+        struct alignas(64) ParseArena {
+            std::array<std::byte, 64 * 1024> buffer;
+            std::pmr::monotonic_buffer_resource resource{buffer.data(), buffer.size()};
+        };
+    }
+
+    /**
+     * Compiles every source in parallel. results[i] always belongs to sources[i], and since compile()
+     * is deterministic the output (including error offsets and messages) does not depend on the schedule.
+     **/
+    inline auto parse_all(std::span<const std::string_view> sources, WorkStealingPool& pool) -> std::vector<CompileResult> {
+        std::vector<CompileResult> results(sources.size(), std::unexpected(CompileError{0, {}}));
+        auto arenas = std::make_unique<detail::ParseArena[]>(pool.size());
+
+        pool.parallel_for(sources.size(), detail::parse_grain, [&](size_t begin, size_t end, size_t worker) {
+            auto& arena = arenas[worker].resource;
+            for (size_t i = begin; i < end; ++i) {
+                results[i] = compile(sources[i], &arena);
+                arena.release();
+            }
+        });
+        return results;
+    }
+
+    inline auto parse_all(std::span<const std::string_view> sources) -> std::vector<CompileResult> {
+        WorkStealingPool pool;
+        return parse_all(sources, pool);
+    }
+}
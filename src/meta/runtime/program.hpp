@@ -0,0 +1,144 @@
+//
+// Created by Maksym Pasichnyk on 19.10.2026.
+//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "metrics.hpp"
+
+namespace meta::runtime {
+    /** runtime formulas operate on the same type as $fn called with int arguments **/
+    using Value = int32_t;
+
+    /** upper bound for the evaluation stack, compile() rejects deeper expressions **/
+    static constexpr size_t max_stack_size = 512;
+
+    enum class OpCode : uint8_t {
+        Load,           // push args[arg]
+        Const,          // push constants[arg]
+        Neg,
+        Not,
+        BitNot,
+        Add,
+        Sub,
+        Mul,
+        Div,
+        Less,
+        LessEqual,
+        Greater,
+        GreaterEqual,
+    };
+
+    static_assert(static_cast<size_t>(OpCode::GreaterEqual) < opcode_slots);
+
+    struct Instruction {
+        OpCode op;
+        uint8_t reserved[3]{};
+        uint32_t arg = 0;
+    };
+
+    static_assert(sizeof(Instruction) == 8);
+
+    /** non-owning program representation, everything the evaluators need **/
+    struct ProgramView {
+        std::span<const Instruction> code;
+        std::span<const Value> constants;
+        uint32_t arity = 0;
+        uint32_t stack_size = 0;
+    };
+
+    struct Program {
+        std::vector<std::string> params;
+        std::vector<Instruction> code;
+        std::vector<Value> constants;
+        uint32_t stack_size = 0;
+
+        [[nodiscard]] auto view() const -> ProgramView {
+            return ProgramView{code, constants, static_cast<uint32_t>(params.size()), stack_size};
+        }
+
+        auto operator()(std::span<const Value> args) const -> Value;
+    };
+
+    namespace detail {
+        // arithmetic wraps instead of being undefined, division by zero (and INT_MIN / -1) yields 0
+        constexpr auto apply_unary(OpCode op, Value a) -> Value {
+            switch (op) {
+                case OpCode::Neg:
+                    return static_cast<Value>(0u - static_cast<uint32_t>(a));
+                case OpCode::Not:
+                    return a == 0 ? 1 : 0;
+                case OpCode::BitNot:
+                    return ~a;
+                default:
+                    return 0;
+            }
+        }
+
+        constexpr auto apply_binary(OpCode op, Value a, Value b) -> Value {
+            switch (op) {
+                case OpCode::Add:
+                    return static_cast<Value>(static_cast<uint32_t>(a) + static_cast<uint32_t>(b));
+                case OpCode::Sub:
+                    return static_cast<Value>(static_cast<uint32_t>(a) - static_cast<uint32_t>(b));
+                case OpCode::Mul:
+                    return static_cast<Value>(static_cast<uint32_t>(a) * static_cast<uint32_t>(b));
+                case OpCode::Div:
+                    if (b == 0 || (b == -1 && a == INT32_MIN)) {
+                        return 0;
+                    }
+                    return a / b;
+                case OpCode::Less:
+                    return a < b ? 1 : 0;
+                case OpCode::LessEqual:
+                    return a <= b ? 1 : 0;
+                case OpCode::Greater:
+                    return a > b ? 1 : 0;
+                case OpCode::GreaterEqual:
+                    return a >= b ? 1 : 0;
+                default:
+                    return 0;
+            }
+        }
+    }
+
+    /** scalar interpreter, reference semantics for every other evaluator **/
+    inline auto evaluate(const ProgramView& program, std::span<const Value> args) -> Value {
+        // left uninitialized, verified code writes every slot before reading it; stack[0] is set so
+        // the final read is initialized on every path the compiler can see, even for empty code
+        std::array<Value, max_stack_size> stack;
+        stack[0] = 0;
+        size_t sp = 0;
+        for (const auto& instruction : program.code) {
+            switch (instruction.op) {
+                case OpCode::Load:
+                    stack[sp++] = args[instruction.arg];
+                    break;
+                case OpCode::Const:
+                    stack[sp++] = program.constants[instruction.arg];
+                    break;
+                case OpCode::Neg:
+                case OpCode::Not:
+                case OpCode::BitNot:
+                    stack[sp - 1] = detail::apply_unary(instruction.op, stack[sp - 1]);
+                    break;
+                default:
+                    sp -= 1;
+                    stack[sp - 1] = detail::apply_binary(instruction.op, stack[sp - 1], stack[sp]);
+                    break;
+            }
+        }
+        detail::record_evaluation(program.code, 1);
+        return stack[0];
+    }
+
+    inline auto Program::operator()(std::span<const Value> args) const -> Value {
+        return evaluate(view(), args);
+    }
+}
@@ -0,0 +1,187 @@
+//
+// Created by Maksym Pasichnyk on 19.10.2026.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace meta::runtime {
+    /**
+     * Fork-join pool for data-parallel loops.
+     *
+     * parallel_for splits the index space into ranges and deals them out to per-worker deques in contiguous blocks.
+     * A worker pops from the back of its own deque and, once it is empty, steals from the front of the others.
+     * The calling thread participates as worker 0, so a pool of size 1 runs everything inline.
+     **/
+    class WorkStealingPool {
+    public:
+        explicit WorkStealingPool(size_t size = std::max(1u, std::thread::hardware_concurrency())) : queues(std::max<size_t>(1, size)) {
+            for (size_t worker = 1; worker < queues.size(); ++worker) {
+                threads.emplace_back([this, worker] {
+                    run(worker);
+                });
+            }
+        }
+
+        ~WorkStealingPool() {
+            {
+                std::lock_guard lock(mutex);
+                stop = true;
+            }
+            wake.notify_all();
+            for (auto& thread : threads) {
+                thread.join();
+            }
+        }
+
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        auto operator=(const WorkStealingPool&) -> WorkStealingPool& = delete;
+
+        [[nodiscard]] auto size() const -> size_t {
+            return queues.size();
+        }
+
+        /**
+         * calls fn(begin, end, worker) for disjoint ranges covering [0, count), returns when all of them finished;
+         * if fn throws, the ranges not started yet are skipped and the first exception is rethrown here
+         **/
+        template<typename Fn>
+        void parallel_for(size_t count, size_t grain, Fn&& fn) {
+            if (count == 0) {
+                return;
+            }
+            grain = std::max<size_t>(1, grain);
+            auto ranges = (count + grain - 1) / grain;
+            auto per_worker = (ranges + queues.size() - 1) / queues.size();
+
+            std::lock_guard serial(submit);
+            for (size_t worker = 0; worker < queues.size(); ++worker) {
+                std::lock_guard lock(queues[worker].mutex);
+                for (size_t r = worker * per_worker; r < std::min(ranges, (worker + 1) * per_worker); ++r) {
+                    queues[worker].ranges.emplace_back(Range{r * grain, std::min(count, (r + 1) * grain)});
+                }
+            }
+
+            {
+                std::lock_guard lock(mutex);
+                job = [&fn](size_t begin, size_t end, size_t worker) {
+                    fn(begin, end, worker);
+                };
+                active = queues.size();
+                generation += 1;
+            }
+            wake.notify_all();
+
+            drain(0);
+
+            std::unique_lock lock(mutex);
+            done.wait(lock, [this] {
+                return active == 0;
+            });
+            job = nullptr;
+            failed.store(false, std::memory_order_relaxed);
+            if (auto exception = std::exchange(error, nullptr)) {
+                lock.unlock();
+                std::rethrow_exception(exception);
+            }
+        }
+
+    private:
+        struct Range {
+            size_t begin;
+            size_t end;
+        };
+
+        struct alignas(64) Queue {
+            std::mutex mutex;
+            std::deque<Range> ranges;
+        };
+
+        auto pop(size_t worker) -> std::optional<Range> {
+            auto& own = queues[worker];
+            {
+                std::lock_guard lock(own.mutex);
+                if (!own.ranges.empty()) {
+                    auto range = own.ranges.back();
+                    own.ranges.pop_back();
+                    return range;
+                }
+            }
+            for (size_t i = 1; i < queues.size(); ++i) {
+                auto& victim = queues[(worker + i) % queues.size()];
+                std::lock_guard lock(victim.mutex);
+                if (!victim.ranges.empty()) {
+                    auto range = victim.ranges.front();
+                    victim.ranges.pop_front();
+                    return range;
+                }
+            }
+            return std::nullopt;
+        }
+
+        // ranges never spawn new ranges, so once every deque is empty there is nothing left to steal;
+        // after a failure the rest are still popped, so the deques are empty for the next parallel_for
+        void drain(size_t worker) {
+            while (auto range = pop(worker)) {
+                if (failed.load(std::memory_order_relaxed)) {
+                    continue;
+                }
+                try {
+                    job(range->begin, range->end, worker);
+                } catch (...) {
+                    std::lock_guard lock(mutex);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                    failed.store(true, std::memory_order_relaxed);
+                }
+            }
+            std::lock_guard lock(mutex);
+            if (--active == 0) {
+                done.notify_all();
+            }
+        }
+
+        void run(size_t worker) {
+            size_t seen = 0;
+            while (true) {
+                {
+                    std::unique_lock lock(mutex);
+                    wake.wait(lock, [&] {
+                        return stop || generation != seen;
+                    });
+                    if (stop) {
+                        return;
+                    }
+                    seen = generation;
+                }
+                drain(worker);
+            }
+        }
+
+        std::vector<Queue> queues;
+        std::vector<std::thread> threads;
+
+        std::mutex submit;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+        std::function<void(size_t, size_t, size_t)> job;
+        std::exception_ptr error;
+        std::atomic<bool> failed{false};
+        size_t generation = 0;
+        size_t active = 0;
+        bool stop = false;
+    };
+}
@@ -0,0 +1,149 @@
+//
+// Created by Maksym Pasichnyk on 19.10.2026.
+//
+
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cassert>
+
+#include "compiler.hpp"
+#include "mapped_file.hpp"
+
+namespace meta::runtime {
+    /**
+     * Lazy tokenizer over a string_view (usually a MappedFile). Tokens are produced on demand into a fixed
+     * ring buffer, so memory does not depend on the input size; peek(k) looks ahead up to `Lookahead` tokens.
+     **/
+    template<size_t Lookahead = 64>
+    struct TokenReader {
+        static constexpr size_t capacity = std::bit_ceil(Lookahead);
+
+        explicit TokenReader(std::string_view s) : source_stream{s} {}
+
+        /** k-th token after the current one, End once the input is exhausted **/
+        auto peek(size_t k = 0) -> Token {
+            assert(k < Lookahead);
+            fill(k + 1);
+            return tokens[(head + k) & (capacity - 1)];
+        }
+
+        /** byte offset of the k-th token after the current one, the input size past the end **/
+        auto offset(size_t k = 0) -> size_t {
+            assert(k < Lookahead);
+            fill(k + 1);
+            return offsets[(head + k) & (capacity - 1)];
+        }
+
+        auto next() -> Token {
+            auto tk = peek();
+            if (!tk.is_end()) {
+                head += 1;
+                count -= 1;
+            }
+            return tk;
+        }
+
+        [[nodiscard]] auto source() const -> std::string_view {
+            return source_stream.s;
+        }
+
+    private:
+        void fill(size_t needed) {
+            while (count < needed) {
+                auto slot = (head + count) & (capacity - 1);
+                // past the end the stream keeps returning End, and next() never consumes it
+                tokens[slot] = source_stream.token();
+                offsets[slot] = source_stream.from;
+                count += 1;
+            }
+        }
+
+        FastSourceStream source_stream;
+        std::array<Token, capacity> tokens{};
+        std::array<size_t, capacity> offsets{};
+        size_t head = 0;
+        size_t count = 0;
+    };
+
+    struct Snippet {
+        size_t offset;
+        std::string_view source;
+    };
+
+    /** longest snippet compile_stream keeps in memory, longer ones are reported as errors and skipped up to the next `;` **/
+    static constexpr size_t max_snippet_tokens = 16 * 1024;
+
+    /**
+     * Compiles every `;`-separated snippet of `source` in order, calling fn(const Snippet&, CompileResult)
+     * for each one. Only the current snippet's tokens are kept, error offsets are relative to the snippet.
+     * Formulas never contain `;`, so every `;` ends a snippet and a typo costs only the snippet it is in.
+     **/
+    template<size_t Lookahead = 64, typename Fn>
+    auto compile_stream(TokenReader<Lookahead>& reader, Fn&& fn) -> size_t {
+        std::pmr::vector<Token> tokens;
+        std::pmr::vector<size_t> offsets;
+        size_t snippets = 0;
+
+        std::array<std::byte, 64 * 1024> buffer;
+        std::pmr::monotonic_buffer_resource scratch{buffer.data(), buffer.size()};
+
+        while (!reader.peek().is_end()) {
+            tokens.clear();
+            offsets.clear();
+
+            auto from = reader.offset();
+            auto too_long = false;
+            while (!reader.peek().is_end() && !reader.peek().is(TokenType::Semicolon)) {
+                if (tokens.size() == max_snippet_tokens) {
+                    too_long = true;
+                    break;
+                }
+                offsets.emplace_back(reader.offset() - from);
+                tokens.emplace_back(reader.next());
+            }
+            // the rest of the snippet is dropped, so memory stays bounded and the next one starts clean
+            auto error_offset = reader.offset() - from;
+            while (too_long && !reader.peek().is_end() && !reader.peek().is(TokenType::Semicolon)) {
+                reader.next();
+            }
+            auto to = reader.offset();
+            reader.next();
+
+            if (tokens.empty()) {
+                continue;
+            }
+            auto snippet = Snippet{from, reader.source().substr(from, to - from)};
+            if (too_long) {
+                fn(snippet, CompileResult(std::unexpected(CompileError{error_offset, "snippet is too long"})));
+            } else {
+                fn(snippet, compile_tokens(snippet.source, tokens, offsets, &scratch));
+                scratch.release();
+            }
+            snippets += 1;
+        }
+        return snippets;
+    }
+
+    /** compile_stream over a memory-mapped file, pages behind the reader are released as it goes **/
+    template<typename Fn>
+    auto compile_file(const char* path, Fn&& fn) -> std::expected<size_t, std::error_code> {
+        static constexpr size_t release_interval = 16 << 20;
+
+        auto file = MappedFile::open(path);
+        if (!file) {
+            return std::unexpected(file.error());
+        }
+
+        TokenReader reader(file->view());
+        size_t released = 0;
+        return compile_stream(reader, [&](const Snippet& snippet, auto&& result) {
+            fn(snippet, std::forward<decltype(result)>(result));
+            if (snippet.offset - released >= release_interval) {
+                file->release_before(snippet.offset);
+                released = snippet.offset;
+            }
+        });
+    }
+}
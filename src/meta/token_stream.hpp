@@ -170,9 +170,31 @@ struct SourceStream {
     }
 };
 
+/**
+ * Position in a TokenStream with static storage. Every parse step stores one in a template argument,
+ * so it points at the tokens instead of carrying them, which keeps each step O(1) in the input size.
+ **/
+struct TokenCursor {
+    const Token* tokens;
+    size_t pos{};
+
+    constexpr auto token() const -> Token {
+        return tokens[pos];
+    }
+
+    constexpr auto at(size_t where) const -> TokenCursor {
+        return {tokens, where};
+    }
+
+    constexpr auto current() const -> size_t {
+        return pos;
+    }
+};
+
+/** tokens of a compile-time source, `Capacity` is one more than the number of tokens so the stream ends with End **/
+template<size_t Capacity>
 struct TokenStream {
-    // todo: dynamic size?
-    static_vector<Token, 1024> tokens;
+    static_vector<Token, Capacity> tokens;
     size_t pos{};
 
     constexpr auto token() const -> Token {
@@ -187,9 +209,13 @@ struct TokenStream {
         return pos;
     }
 
+    constexpr auto cursor() const -> TokenCursor {
+        return {tokens.data(), pos};
+    }
+
     static constexpr auto parse(std::string_view s) -> TokenStream {
         SourceStream source_stream{s, 0};
-        static_vector<Token, 1024> tokens{};
+        static_vector<Token, Capacity> tokens{};
         auto tk = source_stream.token();
         while (!tk.is_end()) {
             tokens.emplace_back(tk);
@@ -198,3 +224,12 @@ struct TokenStream {
         return TokenStream{tokens, 0};
     }
 };
+
+static constexpr auto count_tokens(std::string_view s) -> size_t {
+    SourceStream source_stream{s, 0};
+    size_t count = 0;
+    while (!source_stream.token().is_end()) {
+        count += 1;
+    }
+    return count;
+}
@@ -0,0 +1,57 @@
+//
+// Created by Maksym Pasichnyk on 19.10.2026.
+//
+
+#pragma once
+
+#include <concepts>
+#include <type_traits>
+
+/**
+ * Grammar units: a result of apply_rules is declared in a header and defined in exactly one translation unit,
+ * so the combinator tree behind it is instantiated and evaluated once instead of in every file that uses it.
+ * This header is all a user of the declarations needs, it does not pull in the grammar.
+ *
+ *   // formulas.hpp
+ *   META_DECLARE_FN(total, int(int, int));
+ *
+ *   // formulas.cpp
+ *   #include "formulas.hpp"
+ *   META_DEFINE(total, Function, (price quantity) -> price * quantity);
+ *
+ * Values defined this way are no longer constant expressions in other translation units,
+ * and calls go through a function pointer, cross-unit inlining is left to LTO.
+ **/
+namespace meta::unit {
+    template<typename Signature>
+    class Function;
+
+    template<typename R, typename... Args>
+    class Function<R(Args...)> {
+    public:
+        /** accepts the stateless callables that rules produce, e.g. the lambdas returned by `$fn` **/
+        template<typename F> requires std::is_empty_v<F> && std::default_initializable<F> && std::is_invocable_r_v<R, const F&, Args...>
+        consteval Function(F) : fn(&invoke<F>) {}
+
+        auto operator()(Args... args) const -> R {
+            return fn(args...);
+        }
+
+    private:
+        template<typename F>
+        static auto invoke(Args... args) -> R {
+            return static_cast<R>(F{}(args...));
+        }
+
+        R (*fn)(Args...);
+    };
+}
+
+/** declares a grammar result of type `...`, usually in a header **/
+#define META_DECLARE(name, ...) extern const __VA_ARGS__ name
+
+/** declares a callable grammar result with the signature `...` **/
+#define META_DECLARE_FN(name, ...) META_DECLARE(name, meta::unit::Function<__VA_ARGS__>)
+
+/** defines a declared result, evaluated at compile time in this translation unit only **/
+#define META_DEFINE(name, rules, ...) constinit const decltype(name) name = apply_rules(rules, __VA_ARGS__)